@@ -5,6 +5,8 @@
  *
  */
 
+#include <string.h>
+
 #include <zephyr/kernel.h>
 
 #include <zephyr/logging/log.h>
@@ -46,8 +48,111 @@ struct wpm_status_state {
     uint8_t wpm;
 };
 
-static void draw_top(lv_obj_t *widget, lv_color_t cbuf[], const struct status_state *state) {
-    lv_obj_t *canvas = lv_obj_get_child(widget, 0);
+enum status_region {
+    STATUS_REGION_BATTERY,
+    STATUS_REGION_OUTPUT,
+    STATUS_REGION_WPM,
+    STATUS_REGION_PROFILES,
+    STATUS_REGION_LAYER,
+    STATUS_REGION_COUNT,
+};
+
+struct status_region_def {
+    uint8_t canvas;
+    // Area of the region on the unrotated canvas. The regions of a canvas have to tile it, any
+    // pixel outside of them is never flushed to the display.
+    lv_area_t area;
+};
+
+static const struct status_region_def status_regions[] = {
+    [STATUS_REGION_BATTERY] = {.canvas = 0, .area = {0, 0, 33, 20}},
+    [STATUS_REGION_OUTPUT] = {.canvas = 0, .area = {34, 0, CANVAS_SIZE - 1, 20}},
+    [STATUS_REGION_WPM] = {.canvas = 0, .area = {0, 21, CANVAS_SIZE - 1, CANVAS_SIZE - 1}},
+    [STATUS_REGION_PROFILES] = {.canvas = 1, .area = {0, 0, CANVAS_SIZE - 1, CANVAS_SIZE - 1}},
+    [STATUS_REGION_LAYER] = {.canvas = 2, .area = {0, 0, CANVAS_SIZE - 1, CANVAS_SIZE - 1}},
+};
+
+BUILD_ASSERT(ARRAY_SIZE(status_regions) == STATUS_REGION_COUNT,
+             "Every status region needs an entry in the region table");
+
+#define CANVAS_REGIONS(canvas_idx)                                                                 \
+    ((canvas_idx) == 0   ? (BIT(STATUS_REGION_BATTERY) | BIT(STATUS_REGION_OUTPUT) |               \
+                          BIT(STATUS_REGION_WPM))                                                  \
+     : (canvas_idx) == 1 ? BIT(STATUS_REGION_PROFILES)                                             \
+                         : BIT(STATUS_REGION_LAYER))
+
+static __maybe_unused bool regions_tile_canvases(void) {
+    uint32_t covered[3] = {0};
+
+    for (int i = 0; i < STATUS_REGION_COUNT; i++) {
+        const struct status_region_def *region = &status_regions[i];
+
+        for (int j = i + 1; j < STATUS_REGION_COUNT; j++) {
+            lv_area_t overlap;
+            if (status_regions[j].canvas == region->canvas &&
+                _lv_area_intersect(&overlap, &region->area, &status_regions[j].area)) {
+                return false;
+            }
+        }
+
+        covered[region->canvas] += lv_area_get_size(&region->area);
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(covered); i++) {
+        if (covered[i] != CANVAS_SIZE * CANVAS_SIZE) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static lv_color_t *canvas_buffer(struct zmk_widget_status *widget, uint8_t canvas_idx) {
+    switch (canvas_idx) {
+    case 0:
+        return widget->cbuf;
+    case 1:
+        return widget->cbuf2;
+    default:
+        return widget->cbuf3;
+    }
+}
+
+// Draws are done unrotated on the hidden scratch canvas, and only the regions that changed are
+// then rotated onto the visible canvas, so the display only has to flush those areas.
+static void flush_regions(struct zmk_widget_status *widget, uint8_t canvas_idx, uint8_t regions) {
+    lv_obj_t *canvas = lv_obj_get_child(widget->obj, canvas_idx);
+    lv_color_t *cbuf = canvas_buffer(widget, canvas_idx);
+    bool first_draw = (widget->drawn_regions & CANVAS_REGIONS(canvas_idx)) == 0;
+
+    for (int i = 0; i < STATUS_REGION_COUNT; i++) {
+        if (regions & BIT(i)) {
+            rotate_canvas_area(canvas, cbuf, get_scratch_buffer(), &status_regions[i].area);
+        }
+    }
+
+    widget->drawn_regions |= regions;
+
+    // The canvas may not have been laid out yet the first time around
+    if (first_draw) {
+        lv_obj_invalidate(canvas);
+    }
+}
+
+static uint8_t regions_to_draw(struct zmk_widget_status *widget, uint8_t canvas_idx,
+                               uint8_t changed) {
+    // Regions that were never drawn still hold the empty canvas buffer
+    return (changed | ~widget->drawn_regions) & CANVAS_REGIONS(canvas_idx);
+}
+
+static void draw_top(struct zmk_widget_status *widget, uint8_t changed) {
+    uint8_t regions = regions_to_draw(widget, 0, changed);
+    if (regions == 0) {
+        return;
+    }
+
+    const struct status_state *state = &widget->state;
+    lv_obj_t *canvas = widget->scratch;
 
     lv_draw_label_dsc_t label_dsc;
     init_label_dsc(&label_dsc, LVGL_FOREGROUND, &lv_font_montserrat_16, LV_TEXT_ALIGN_RIGHT);
@@ -120,12 +225,17 @@ static void draw_top(lv_obj_t *widget, lv_color_t cbuf[], const struct status_st
     }
     lv_canvas_draw_line(canvas, points, 10, &line_dsc);
 
-    // Rotate canvas
-    rotate_canvas(canvas, cbuf);
+    flush_regions(widget, 0, regions);
 }
 
-static void draw_middle(lv_obj_t *widget, lv_color_t cbuf[], const struct status_state *state) {
-    lv_obj_t *canvas = lv_obj_get_child(widget, 1);
+static void draw_middle(struct zmk_widget_status *widget, uint8_t changed) {
+    uint8_t regions = regions_to_draw(widget, 1, changed);
+    if (regions == 0) {
+        return;
+    }
+
+    const struct status_state *state = &widget->state;
+    lv_obj_t *canvas = widget->scratch;
 
     lv_draw_rect_dsc_t rect_black_dsc;
     init_rect_dsc(&rect_black_dsc, LVGL_BACKGROUND);
@@ -174,12 +284,17 @@ static void draw_middle(lv_obj_t *widget, lv_color_t cbuf[], const struct status
                             (selected ? &label_dsc_black : &label_dsc), label);
     }
 
-    // Rotate canvas
-    rotate_canvas(canvas, cbuf);
+    flush_regions(widget, 1, regions);
 }
 
-static void draw_bottom(lv_obj_t *widget, lv_color_t cbuf[], const struct status_state *state) {
-    lv_obj_t *canvas = lv_obj_get_child(widget, 2);
+static void draw_bottom(struct zmk_widget_status *widget, uint8_t changed) {
+    uint8_t regions = regions_to_draw(widget, 2, changed);
+    if (regions == 0) {
+        return;
+    }
+
+    const struct status_state *state = &widget->state;
+    lv_obj_t *canvas = widget->scratch;
 
     lv_draw_rect_dsc_t rect_black_dsc;
     init_rect_dsc(&rect_black_dsc, LVGL_BACKGROUND);
@@ -200,19 +315,21 @@ static void draw_bottom(lv_obj_t *widget, lv_color_t cbuf[], const struct status
         lv_canvas_draw_text(canvas, 0, 5, 68, &label_dsc, state->layer_label);
     }
 
-    // Rotate canvas
-    rotate_canvas(canvas, cbuf);
+    flush_regions(widget, 2, regions);
 }
 
 static void set_battery_status(struct zmk_widget_status *widget,
                                struct battery_status_state state) {
+    struct status_state old = widget->state;
+
 #if IS_ENABLED(CONFIG_USB_DEVICE_STACK)
     widget->state.charging = state.usb_present;
 #endif /* IS_ENABLED(CONFIG_USB_DEVICE_STACK) */
 
     widget->state.battery = state.level;
 
-    draw_top(widget->obj, widget->cbuf, &widget->state);
+    bool changed = old.battery != widget->state.battery || old.charging != widget->state.charging;
+    draw_top(widget, changed ? BIT(STATUS_REGION_BATTERY) : 0);
 }
 
 static void battery_status_update_cb(struct battery_status_state state) {
@@ -241,6 +358,8 @@ ZMK_SUBSCRIPTION(widget_battery_status, zmk_usb_conn_state_changed);
 
 static void set_output_status(struct zmk_widget_status *widget,
                               const struct output_status_state *state) {
+    struct status_state old = widget->state;
+
     widget->state.selected_endpoint = state->selected_endpoint;
     widget->state.active_profile_index = state->active_profile_index;
     widget->state.active_profile_connected = state->active_profile_connected;
@@ -250,8 +369,19 @@ static void set_output_status(struct zmk_widget_status *widget,
         widget->state.profiles_bonded[i] = state->profiles_bonded[i];
     }
 
-    draw_top(widget->obj, widget->cbuf, &widget->state);
-    draw_middle(widget->obj, widget->cbuf2, &widget->state);
+    bool output_changed =
+        !zmk_endpoint_instance_eq(old.selected_endpoint, widget->state.selected_endpoint) ||
+        old.active_profile_connected != widget->state.active_profile_connected ||
+        old.active_profile_bonded != widget->state.active_profile_bonded;
+    bool profiles_changed =
+        old.active_profile_index != widget->state.active_profile_index ||
+        memcmp(old.profiles_connected, widget->state.profiles_connected,
+               sizeof(old.profiles_connected)) != 0 ||
+        memcmp(old.profiles_bonded, widget->state.profiles_bonded,
+               sizeof(old.profiles_bonded)) != 0;
+
+    draw_top(widget, output_changed ? BIT(STATUS_REGION_OUTPUT) : 0);
+    draw_middle(widget, profiles_changed ? BIT(STATUS_REGION_PROFILES) : 0);
 }
 
 static void output_status_update_cb(struct output_status_state state) {
@@ -285,10 +415,15 @@ ZMK_SUBSCRIPTION(widget_output_status, zmk_ble_active_profile_changed);
 #endif
 
 static void set_layer_status(struct zmk_widget_status *widget, struct layer_status_state state) {
+    bool changed = widget->state.layer_index != state.index ||
+                   (widget->state.layer_label != state.label &&
+                    (widget->state.layer_label == NULL || state.label == NULL ||
+                     strcmp(widget->state.layer_label, state.label) != 0));
+
     widget->state.layer_index = state.index;
     widget->state.layer_label = state.label;
 
-    draw_bottom(widget->obj, widget->cbuf3, &widget->state);
+    draw_bottom(widget, changed ? BIT(STATUS_REGION_LAYER) : 0);
 }
 
 static void layer_status_update_cb(struct layer_status_state state) {
@@ -308,12 +443,17 @@ ZMK_DISPLAY_WIDGET_LISTENER(widget_layer_status, struct layer_status_state, laye
 ZMK_SUBSCRIPTION(widget_layer_status, zmk_layer_state_changed);
 
 static void set_wpm_status(struct zmk_widget_status *widget, struct wpm_status_state state) {
+    bool changed = false;
+
     for (int i = 0; i < 9; i++) {
+        changed |= widget->state.wpm[i] != widget->state.wpm[i + 1];
         widget->state.wpm[i] = widget->state.wpm[i + 1];
     }
+    changed |= widget->state.wpm[9] != state.wpm;
     widget->state.wpm[9] = state.wpm;
 
-    draw_top(widget->obj, widget->cbuf, &widget->state);
+    // A flat graph of an unchanged value looks the same after shifting it
+    draw_top(widget, changed ? BIT(STATUS_REGION_WPM) : 0);
 }
 
 static void wpm_status_update_cb(struct wpm_status_state state) {
@@ -330,6 +470,8 @@ ZMK_DISPLAY_WIDGET_LISTENER(widget_wpm_status, struct wpm_status_state, wpm_stat
 ZMK_SUBSCRIPTION(widget_wpm_status, zmk_wpm_state_changed);
 
 int zmk_widget_status_init(struct zmk_widget_status *widget, lv_obj_t *parent) {
+    __ASSERT(regions_tile_canvases(), "Status regions don't tile their canvases");
+
     widget->obj = lv_obj_create(parent);
     lv_obj_set_size(widget->obj, 160, 68);
     lv_obj_t *top = lv_canvas_create(widget->obj);
@@ -341,6 +483,11 @@ int zmk_widget_status_init(struct zmk_widget_status *widget, lv_obj_t *parent) {
     lv_obj_t *bottom = lv_canvas_create(widget->obj);
     lv_obj_align(bottom, LV_ALIGN_TOP_LEFT, -44, 0);
     lv_canvas_set_buffer(bottom, widget->cbuf3, CANVAS_SIZE, CANVAS_SIZE, LV_IMG_CF_TRUE_COLOR);
+    widget->scratch = lv_canvas_create(widget->obj);
+    lv_obj_add_flag(widget->scratch, LV_OBJ_FLAG_HIDDEN);
+    lv_canvas_set_buffer(widget->scratch, get_scratch_buffer(), CANVAS_SIZE, CANVAS_SIZE,
+                         LV_IMG_CF_TRUE_COLOR);
+    widget->drawn_regions = 0;
 
     sys_slist_append(&widgets, &widget->node);
     widget_battery_status_init();
@@ -17,6 +17,10 @@ struct zmk_widget_status {
     lv_color_t cbuf[CANVAS_SIZE * CANVAS_SIZE];
     lv_color_t cbuf2[CANVAS_SIZE * CANVAS_SIZE];
     lv_color_t cbuf3[CANVAS_SIZE * CANVAS_SIZE];
+    // Hidden canvas the status is drawn on before the changed regions are rotated into place
+    lv_obj_t *scratch;
+    // Bit per status region that has been drawn at least once
+    uint8_t drawn_regions;
     struct status_state state;
 };
 
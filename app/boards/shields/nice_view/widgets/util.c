@@ -10,8 +10,12 @@
 
 LV_IMG_DECLARE(bolt);
 
+// Shared by everything that draws on the display thread, its content only lasts for one draw
+static lv_color_t cbuf_tmp[CANVAS_SIZE * CANVAS_SIZE];
+
+lv_color_t *get_scratch_buffer(void) { return cbuf_tmp; }
+
 void rotate_canvas(lv_obj_t *canvas, lv_color_t cbuf[]) {
-    static lv_color_t cbuf_tmp[CANVAS_SIZE * CANVAS_SIZE];
     memcpy(cbuf_tmp, cbuf, sizeof(cbuf_tmp));
     lv_img_dsc_t img;
     img.data = (void *)cbuf_tmp;
@@ -24,6 +28,24 @@ void rotate_canvas(lv_obj_t *canvas, lv_color_t cbuf[]) {
                         CANVAS_SIZE / 2, true);
 }
 
+void rotate_canvas_area(lv_obj_t *canvas, lv_color_t cbuf[], const lv_color_t src[],
+                        const lv_area_t *area) {
+    // Same 90 degree clockwise rotation around the canvas center as rotate_canvas
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        for (lv_coord_t x = area->x1; x <= area->x2; x++) {
+            cbuf[x * CANVAS_SIZE + (CANVAS_SIZE - 1 - y)] = src[y * CANVAS_SIZE + x];
+        }
+    }
+
+    lv_area_t rotated = {
+        .x1 = canvas->coords.x1 + CANVAS_SIZE - 1 - area->y2,
+        .y1 = canvas->coords.y1 + area->x1,
+        .x2 = canvas->coords.x1 + CANVAS_SIZE - 1 - area->y1,
+        .y2 = canvas->coords.y1 + area->x2,
+    };
+    lv_obj_invalidate_area(canvas, &rotated);
+}
+
 void draw_battery(lv_obj_t *canvas, const struct status_state *state) {
     lv_draw_rect_dsc_t rect_black_dsc;
     init_rect_dsc(&rect_black_dsc, LVGL_BACKGROUND);
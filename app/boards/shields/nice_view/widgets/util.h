@@ -42,7 +42,14 @@ struct battery_status_state {
 #endif
 };
 
+lv_color_t *get_scratch_buffer(void);
 void rotate_canvas(lv_obj_t *canvas, lv_color_t cbuf[]);
+/**
+ * Rotate only the given area of an unrotated drawing in src into the canvas, and invalidate only
+ * the part of the canvas it ends up in.
+ */
+void rotate_canvas_area(lv_obj_t *canvas, lv_color_t cbuf[], const lv_color_t src[],
+                        const lv_area_t *area);
 void draw_battery(lv_obj_t *canvas, const struct status_state *state);
 void init_label_dsc(lv_draw_label_dsc_t *label_dsc, lv_color_t color, const lv_font_t *font,
                     lv_text_align_t align);
@@ -113,6 +113,8 @@ struct zmk_behavior_ref {
 struct zmk_behavior_local_id_map {
     const struct device *device;
     zmk_behavior_local_id_t local_id;
+    // Section index of the entry with the n-th smallest local ID, maintained by the lookup index
+    uint16_t by_local_id;
 };
 
 #endif // IS_ENABLED(CONFIG_ZMK_BEHAVIOR_LOCAL_IDS)
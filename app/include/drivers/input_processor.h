@@ -12,6 +12,7 @@
 #include <string.h>
 #include <zephyr/device.h>
 #include <zephyr/input/input.h>
+#include <zephyr/dt-bindings/input/input-event-codes.h>
 
 #define ZMK_INPUT_PROC_CONTINUE 0
 #define ZMK_INPUT_PROC_STOP 1
@@ -40,14 +41,78 @@ struct zmk_input_processor_state {
     int16_t *remainder;
 };
 
+enum zmk_input_processor_frame_axis {
+    ZMK_INPUT_PROCESSOR_FRAME_AXIS_X,
+    ZMK_INPUT_PROCESSOR_FRAME_AXIS_Y,
+    ZMK_INPUT_PROCESSOR_FRAME_AXIS_WHEEL,
+    ZMK_INPUT_PROCESSOR_FRAME_AXIS_H_WHEEL,
+    ZMK_INPUT_PROCESSOR_FRAME_AXIS_COUNT,
+};
+
+#define ZMK_INPUT_PROCESSOR_FRAME_BUTTONS 5
+
+/**
+ * The relative motion and button changes of a single sync frame, i.e. everything an input device
+ * reported up to and including an event with the sync flag set.
+ */
+struct zmk_input_processor_frame {
+    int16_t rel[ZMK_INPUT_PROCESSOR_FRAME_AXIS_COUNT];
+    // Bit per axis that was reported in the frame, even if its value adds up to zero
+    uint8_t rel_present;
+    // Bits for the INPUT_BTN_0 based buttons pressed and released in the frame
+    uint8_t buttons_set;
+    uint8_t buttons_clear;
+};
+
+struct zmk_input_processor_frame_state {
+    uint8_t input_device_index;
+    // Remainders indexed by axis, or NULL if the processor doesn't track remainders
+    int16_t *remainders;
+};
+
+static inline int zmk_input_processor_frame_axis_for_code(uint16_t code) {
+    switch (code) {
+    case INPUT_REL_X:
+        return ZMK_INPUT_PROCESSOR_FRAME_AXIS_X;
+    case INPUT_REL_Y:
+        return ZMK_INPUT_PROCESSOR_FRAME_AXIS_Y;
+    case INPUT_REL_WHEEL:
+        return ZMK_INPUT_PROCESSOR_FRAME_AXIS_WHEEL;
+    case INPUT_REL_HWHEEL:
+        return ZMK_INPUT_PROCESSOR_FRAME_AXIS_H_WHEEL;
+    default:
+        return -ENOENT;
+    }
+}
+
+static inline uint16_t
+zmk_input_processor_frame_axis_code(enum zmk_input_processor_frame_axis axis) {
+    static const uint16_t codes[] = {INPUT_REL_X, INPUT_REL_Y, INPUT_REL_WHEEL, INPUT_REL_HWHEEL};
+
+    return codes[axis];
+}
+
+#define ZMK_INPUT_PROCESSOR_FRAME_AXIS_BIT_FOR_CODE(code)                                          \
+    (((code) == INPUT_REL_X)        ? BIT(ZMK_INPUT_PROCESSOR_FRAME_AXIS_X)                        \
+     : ((code) == INPUT_REL_Y)      ? BIT(ZMK_INPUT_PROCESSOR_FRAME_AXIS_Y)                        \
+     : ((code) == INPUT_REL_WHEEL)  ? BIT(ZMK_INPUT_PROCESSOR_FRAME_AXIS_WHEEL)                    \
+     : ((code) == INPUT_REL_HWHEEL) ? BIT(ZMK_INPUT_PROCESSOR_FRAME_AXIS_H_WHEEL)                  \
+                                    : 0)
+
 // TODO: Need the ability to store remainders? Some data passed in?
 typedef int (*zmk_input_processor_handle_event_callback_t)(const struct device *dev,
                                                            struct input_event *event,
                                                            uint32_t param1, uint32_t param2,
                                                            struct zmk_input_processor_state *state);
 
+typedef int (*zmk_input_processor_handle_frame_callback_t)(
+    const struct device *dev, struct zmk_input_processor_frame *frame, uint32_t param1,
+    uint32_t param2, struct zmk_input_processor_frame_state *state);
+
 __subsystem struct zmk_input_processor_driver_api {
     zmk_input_processor_handle_event_callback_t handle_event;
+    // Optional, processors without it get each frame as separate events through handle_event
+    zmk_input_processor_handle_frame_callback_t handle_frame;
 };
 
 __syscall int zmk_input_processor_handle_event(const struct device *dev, struct input_event *event,
@@ -68,4 +133,33 @@ static inline int z_impl_zmk_input_processor_handle_event(const struct device *d
     return api->handle_event(dev, event, param1, param2, state);
 }
 
+/**
+ * @brief Process a frame by passing each of its axes and button changes through the processor's
+ * per-event handler, and collecting the resulting events back into the frame. Events a processor
+ * turns into something a frame can't hold are dropped, just like the input listener drops them.
+ * Returns ZMK_INPUT_PROC_STOP if the processor stopped every event of the frame.
+ */
+int zmk_input_processor_handle_frame_with_events(const struct device *dev,
+                                                 struct zmk_input_processor_frame *frame,
+                                                 uint32_t param1, uint32_t param2,
+                                                 struct zmk_input_processor_frame_state *state);
+
+__syscall int zmk_input_processor_handle_frame(const struct device *dev,
+                                               struct zmk_input_processor_frame *frame,
+                                               uint32_t param1, uint32_t param2,
+                                               struct zmk_input_processor_frame_state *state);
+
+static inline int z_impl_zmk_input_processor_handle_frame(
+    const struct device *dev, struct zmk_input_processor_frame *frame, uint32_t param1,
+    uint32_t param2, struct zmk_input_processor_frame_state *state) {
+    const struct zmk_input_processor_driver_api *api =
+        (const struct zmk_input_processor_driver_api *)dev->api;
+
+    if (api->handle_frame == NULL) {
+        return zmk_input_processor_handle_frame_with_events(dev, frame, param1, param2, state);
+    }
+
+    return api->handle_frame(dev, frame, param1, param2, state);
+}
+
 #include <syscalls/input_processor.h>
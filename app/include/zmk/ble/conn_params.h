@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2025 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/types.h>
+
+enum zmk_ble_conn_params_profile {
+    ZMK_BLE_CONN_PARAMS_PROFILE_ACTIVE,
+    ZMK_BLE_CONN_PARAMS_PROFILE_IDLE,
+    ZMK_BLE_CONN_PARAMS_PROFILE_LONG_IDLE,
+    ZMK_BLE_CONN_PARAMS_PROFILE_COUNT,
+};
+
+struct zmk_ble_conn_params_stats {
+    // Total time spent in each profile, including the current one, in ms
+    uint64_t time_in_profile[ZMK_BLE_CONN_PARAMS_PROFILE_COUNT];
+    uint32_t transitions;
+    uint32_t update_requests;
+    uint32_t update_failures;
+};
+
+enum zmk_ble_conn_params_profile zmk_ble_conn_params_get_profile(void);
+
+int zmk_ble_conn_params_get_stats(struct zmk_ble_conn_params_stats *stats);
+
+// Keeps the active profile regardless of activity until released, using the given peripheral
+// latency on host links. Used by features like Studio that need a responsive link on their own.
+void zmk_ble_conn_params_hold_active(uint16_t host_latency);
+
+void zmk_ble_conn_params_release_active(void);
@@ -15,6 +15,16 @@ struct k_work_q *zmk_display_work_q(void);
 bool zmk_display_is_initialized(void);
 int zmk_display_init(void);
 
+/**
+ * @brief Run LVGL as soon as possible to render changes made to the UI.
+ *
+ * The display is only processed when something requested it, an LVGL timer is due or
+ * `CONFIG_ZMK_DISPLAY_IDLE_TICK_PERIOD_MS` elapses, so this should be called after changing LVGL
+ * objects for the change to show up immediately. Widgets using `ZMK_DISPLAY_WIDGET_LISTENER` don't
+ * need to call it themselves.
+ */
+void zmk_display_request_update(void);
+
 /**
  * @brief Macro to define a ZMK event listener that handles the thread safety of fetching
  * the necessary state from the system work queue context, invoking a work callback
@@ -39,7 +49,10 @@ int zmk_display_init(void);
         k_mutex_unlock(&listener##_mutex);                                                         \
         return copy;                                                                               \
     };                                                                                             \
-    static void listener##_work_cb(struct k_work *work) { cb(listener##_get_local_state()); };     \
+    static void listener##_work_cb(struct k_work *work) {                                          \
+        cb(listener##_get_local_state());                                                          \
+        zmk_display_request_update();                                                              \
+    };                                                                                             \
     K_WORK_DEFINE(listener##_work, listener##_work_cb);                                            \
     static void listener##_refresh_state(const zmk_event_t *eh) {                                  \
         k_mutex_lock(&listener##_mutex, K_FOREVER);                                                \
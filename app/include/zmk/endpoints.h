@@ -72,6 +72,12 @@ int zmk_endpoints_send_report(uint16_t usage_page);
 
 #if IS_ENABLED(CONFIG_ZMK_POINTING)
 int zmk_endpoints_send_mouse_report();
+
+/**
+ * Get how often the host of the current endpoint takes a mouse report, in microseconds. That is
+ * the USB polling interval or the BLE connection interval. Returns 0 if it isn't known.
+ */
+uint32_t zmk_endpoints_mouse_report_interval_us(void);
 #endif // IS_ENABLED(CONFIG_ZMK_POINTING)
 
 void zmk_endpoints_clear_current(void);
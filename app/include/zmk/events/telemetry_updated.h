@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2025 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zmk/event_manager.h>
+#include <zmk/telemetry.h>
+
+struct zmk_telemetry_updated {
+    struct zmk_telemetry_snapshot snapshot;
+};
+
+ZMK_EVENT_DECLARE(zmk_telemetry_updated);
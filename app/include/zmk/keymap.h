@@ -37,8 +37,39 @@ typedef uint8_t zmk_keymap_layer_id_t;
  */
 typedef uint8_t zmk_keymap_layer_index_t;
 
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_STATE_64)
+
+typedef uint64_t zmk_keymap_layers_state_t;
+
+#define ZMK_KEYMAP_LAYER_BIT(_layer) BIT64(_layer)
+
+#else
+
 typedef uint32_t zmk_keymap_layers_state_t;
 
+#define ZMK_KEYMAP_LAYER_BIT(_layer) BIT(_layer)
+
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_STATE_64)
+
+#define ZMK_KEYMAP_LAYERS_STATE_BITS (sizeof(zmk_keymap_layers_state_t) * 8)
+
+/**
+ * @brief Find the highest layer set in a layer state.
+ *
+ * @retval The highest set layer, or -1 if no layers are set.
+ */
+static inline int zmk_keymap_layers_state_fls(zmk_keymap_layers_state_t state) {
+    if (state == 0) {
+        return -1;
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_STATE_64)
+    return 63 - __builtin_clzll(state);
+#else
+    return 31 - __builtin_clz(state);
+#endif
+}
+
 zmk_keymap_layer_id_t zmk_keymap_layer_index_to_id(zmk_keymap_layer_index_t layer_index);
 
 zmk_keymap_layer_id_t zmk_keymap_layer_default(void);
@@ -51,11 +82,67 @@ int zmk_keymap_layer_toggle(zmk_keymap_layer_id_t layer);
 int zmk_keymap_layer_to(zmk_keymap_layer_id_t layer);
 const char *zmk_keymap_layer_name(zmk_keymap_layer_id_t layer);
 
-const struct zmk_behavior_binding *zmk_keymap_get_layer_binding_at_idx(zmk_keymap_layer_id_t layer,
-                                                                       uint8_t binding_idx);
-int zmk_keymap_set_layer_binding_at_idx(zmk_keymap_layer_id_t layer, uint8_t binding_idx,
+/**
+ * @brief Get the binding of a layer at an index of the selected physical layout.
+ *
+ * The returned binding points into the keymap without holding on to it, so a keymap change made
+ * at the same time can replace it while it's being read.
+ *
+ * @deprecated Use zmk_keymap_copy_layer_binding_at_idx() or zmk_keymap_foreach_layer_binding()
+ * instead, which are safe to call concurrently with keymap changes.
+ */
+__deprecated const struct zmk_behavior_binding *
+zmk_keymap_get_layer_binding_at_idx(zmk_keymap_layer_id_t layer, uint16_t binding_idx);
+
+/**
+ * @brief Copy out the binding of a layer at an index of the selected physical layout.
+ *
+ * Safe to call from any thread, concurrently with keymap changes.
+ *
+ * @retval 0 if the binding was copied.
+ * @retval -EINVAL if the layer or index is invalid or unmapped.
+ */
+int zmk_keymap_copy_layer_binding_at_idx(zmk_keymap_layer_id_t layer, uint16_t binding_idx,
+                                         struct zmk_behavior_binding *binding);
+int zmk_keymap_set_layer_binding_at_idx(zmk_keymap_layer_id_t layer, uint16_t binding_idx,
                                         const struct zmk_behavior_binding binding);
 
+struct zmk_keymap_binding_update {
+    zmk_keymap_layer_id_t layer;
+    uint16_t binding_idx;
+    struct zmk_behavior_binding binding;
+};
+
+/**
+ * @brief Set many bindings at indexes of the selected physical layout at once.
+ *
+ * The bindings are applied together, so key processing sees either all of them or none, e.g. when
+ * importing a whole layer. Like for zmk_keymap_set_layer_binding_at_idx(), the changes are pending
+ * until saved with zmk_keymap_save_changes().
+ *
+ * @retval 0 if every binding was set.
+ * @retval -EINVAL if any layer or index is invalid or unmapped, in which case nothing is set.
+ * @retval -ENOMEM if the changed bindings don't fit, in which case nothing is set.
+ */
+int zmk_keymap_set_bindings(const struct zmk_keymap_binding_update *updates, size_t len);
+
+typedef int (*zmk_keymap_layer_binding_cb_t)(uint16_t binding_idx,
+                                             const struct zmk_behavior_binding *binding,
+                                             void *user_data);
+
+/**
+ * @brief Visit every binding of a layer, in the order of the selected physical layout.
+ *
+ * The position map is only looked up once, and the bindings passed to the callback are a
+ * consistent snapshot of the layer, valid until the callback returns. Unmapped positions are
+ * passed as NULL.
+ *
+ * @retval 0 once every binding was visited.
+ * @retval The first non-zero value returned by the callback, which stops the walk.
+ */
+int zmk_keymap_foreach_layer_binding(zmk_keymap_layer_id_t layer, zmk_keymap_layer_binding_cb_t cb,
+                                     void *user_data);
+
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
 
 int zmk_keymap_add_layer(void);
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2025 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Curves are sampled at this many evenly spaced points over their input range
+#define ZMK_POINTING_CURVE_SEGMENTS 32
+#define ZMK_POINTING_CURVE_POINTS (ZMK_POINTING_CURVE_SEGMENTS + 1)
+
+/**
+ * @brief Fill a curve with from + (to - from) * x^exponent, for x going from 0 to 1.
+ *
+ * @param curve The ZMK_POINTING_CURVE_POINTS values to fill, in units of one.
+ * @param from The value at the start of the curve, in permille.
+ * @param to The value at the end of the curve, in permille.
+ * @param exponent 0 for a flat curve at to, 1 for a linear one, 2 for a quadratic one...
+ * @param one The curve value standing for 1000 permille.
+ */
+void zmk_pointing_curve_build_exponent(uint16_t *curve, uint16_t from, uint16_t to,
+                                       uint8_t exponent, uint16_t one);
+
+/**
+ * @brief Fill a curve by linear interpolation between evenly spaced points.
+ *
+ * @param curve The ZMK_POINTING_CURVE_POINTS values to fill, in units of one.
+ * @param points The points in permille, the first and last ones being the ends of the curve.
+ * @param len The number of points, at least 1.
+ * @param one The curve value standing for 1000 permille.
+ */
+void zmk_pointing_curve_build_from_points(uint16_t *curve, const uint16_t *points, uint8_t len,
+                                          uint16_t one);
@@ -15,6 +15,8 @@ struct zmk_led_hsb {
 int zmk_rgb_underglow_toggle(void);
 int zmk_rgb_underglow_get_state(bool *state);
 int zmk_rgb_underglow_on(void);
+// Sends the current frame to the strip again, e.g. after its power was restored
+int zmk_rgb_underglow_refresh(void);
 int zmk_rgb_underglow_off(void);
 int zmk_rgb_underglow_cycle_effect(int direction);
 int zmk_rgb_underglow_calc_effect(int direction);
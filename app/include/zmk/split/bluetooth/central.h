@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2025 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/types.h>
+
+struct zmk_split_bt_central_connection_stats {
+    // Whether the GATT handles were restored from the cache instead of being discovered
+    bool handles_from_cache;
+    // Time in ms from connecting until the key position notifications were subscribed, or -1
+    int32_t time_to_ready;
+    // Time in ms from connecting until the first key position notification arrived, or -1
+    int32_t time_to_first_key;
+};
+
+int zmk_split_bt_central_get_connection_stats(uint8_t source,
+                                              struct zmk_split_bt_central_connection_stats *stats);
@@ -11,6 +11,11 @@
 
 #define ZMK_SPLIT_RUN_BEHAVIOR_DEV_LEN 9
 
+// Peripherals with up to 128 positions notify their whole position state, optionally followed
+// by a timestamp. Larger peripherals notify only the segment holding the changed position.
+#define ZMK_SPLIT_POS_STATE_LEGACY_LEN 16
+#define ZMK_SPLIT_POS_STATE_SEGMENT_LEN 8
+
 struct sensor_event {
     uint8_t sensor_index;
 
@@ -37,3 +42,16 @@ struct zmk_split_input_event_payload {
     uint32_t value;
     uint8_t sync;
 } __packed;
+
+struct zmk_split_clock_sync_payload {
+    uint32_t central_time;
+    uint32_t peripheral_time;
+} __packed;
+
+struct zmk_split_position_state_segment {
+    // Byte offset of the segment in the position state bitmap (LE)
+    uint16_t offset;
+    uint8_t state[ZMK_SPLIT_POS_STATE_SEGMENT_LEN];
+    // Uptime of the peripheral when this state was captured (LE), 0 if unknown
+    uint32_t timestamp;
+} __packed;
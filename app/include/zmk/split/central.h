@@ -46,3 +46,32 @@ int zmk_split_central_update_hid_indicator(zmk_hid_indicators_t indicators);
 int zmk_split_central_get_peripheral_battery_level(uint8_t source, uint8_t *level);
 
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+
+#define ZMK_SPLIT_CENTRAL_TRANSIT_LATENCY_BUCKETS 10
+
+/**
+ * Transit latency statistics for events received from a peripheral.
+ *
+ * Bucket 0 counts events with a latency under 1ms, bucket `n` counts latencies
+ * in `[2^(n-1), 2^n)` ms, and the last bucket counts everything longer.
+ */
+struct zmk_split_central_transit_latency_stats {
+    bool synced;
+    // Estimated peripheral clock minus central clock, in ms
+    int32_t clock_offset;
+    // Round trip time of the sample the offset estimate was taken from, in ms
+    uint32_t clock_sync_rtt;
+    uint32_t count;
+    uint32_t max;
+    uint64_t total;
+    uint32_t buckets[ZMK_SPLIT_CENTRAL_TRANSIT_LATENCY_BUCKETS];
+};
+
+int zmk_split_central_get_transit_latency_stats(
+    uint8_t source, struct zmk_split_central_transit_latency_stats *stats);
+
+void zmk_split_central_reset_transit_latency_stats(uint8_t source);
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
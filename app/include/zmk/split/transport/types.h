@@ -30,6 +30,7 @@ enum zmk_split_transport_peripheral_event_type {
     ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_SENSOR_EVENT,
     ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_INPUT_EVENT,
     ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_BATTERY_EVENT,
+    ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_CLOCK_SYNC_EVENT,
 };
 
 struct zmk_split_transport_peripheral_event {
@@ -37,8 +38,10 @@ struct zmk_split_transport_peripheral_event {
 
     union {
         struct {
-            uint8_t position;
+            uint16_t position;
             uint8_t pressed;
+            // Peripheral uptime (ms, truncated to 32 bits) when the change happened, 0 if unknown
+            uint32_t timestamp;
         } key_position_event;
 
         struct {
@@ -58,6 +61,11 @@ struct zmk_split_transport_peripheral_event {
         struct {
             uint8_t level;
         } battery_event;
+
+        struct {
+            uint32_t central_time;
+            uint32_t peripheral_time;
+        } clock_sync_event;
     } data;
 } __packed;
 
@@ -66,6 +74,7 @@ enum zmk_split_transport_central_command_type {
     ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_INVOKE_BEHAVIOR,
     ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SET_PHYSICAL_LAYOUT,
     ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SET_HID_INDICATORS,
+    ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SYNC_CLOCK,
 } __packed;
 
 struct zmk_split_transport_central_command {
@@ -87,5 +96,9 @@ struct zmk_split_transport_central_command {
         struct {
             zmk_hid_indicators_t indicators;
         } set_hid_indicators;
+
+        struct {
+            uint32_t central_time;
+        } sync_clock;
     } data;
 } __packed;
\ No newline at end of file
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2025 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+
+enum zmk_telemetry_queue {
+    ZMK_TELEMETRY_QUEUE_KSCAN,
+    ZMK_TELEMETRY_QUEUE_HOG,
+    ZMK_TELEMETRY_QUEUE_SPLIT,
+    ZMK_TELEMETRY_QUEUE_BEHAVIOR,
+    ZMK_TELEMETRY_QUEUE_COUNT,
+};
+
+enum zmk_telemetry_event {
+    ZMK_TELEMETRY_EVENT_POSITION,
+    ZMK_TELEMETRY_EVENT_KEYCODE,
+    ZMK_TELEMETRY_EVENT_LAYER,
+    ZMK_TELEMETRY_EVENT_SENSOR,
+    ZMK_TELEMETRY_EVENT_COUNT,
+};
+
+struct zmk_telemetry_snapshot {
+    // Length of the period the counts below cover, in ms
+    uint32_t period_ms;
+    uint32_t kscan_events;
+    uint32_t hid_reports;
+    uint32_t event_counts[ZMK_TELEMETRY_EVENT_COUNT];
+    // Deepest each queue got during the period
+    uint16_t queue_high_water[ZMK_TELEMETRY_QUEUE_COUNT];
+    // Current connection intervals in 1.25ms units, or 0 when not connected
+    uint16_t host_conn_interval;
+    uint16_t split_conn_interval;
+};
+
+#if IS_ENABLED(CONFIG_ZMK_TELEMETRY)
+
+void zmk_telemetry_record_queue_depth(enum zmk_telemetry_queue queue, uint32_t depth);
+void zmk_telemetry_record_kscan_event(void);
+void zmk_telemetry_record_hid_report(void);
+
+#else
+
+static inline void zmk_telemetry_record_queue_depth(enum zmk_telemetry_queue queue,
+                                                    uint32_t depth) {}
+static inline void zmk_telemetry_record_kscan_event(void) {}
+static inline void zmk_telemetry_record_hid_report(void) {}
+
+#endif // IS_ENABLED(CONFIG_ZMK_TELEMETRY)
@@ -34,7 +34,15 @@ LOG_MODULE_REGISTER(il0323, CONFIG_DISPLAY_LOG_LEVEL);
 #define IL0323_PANEL_LAST_GATE (EPD_PANEL_HEIGHT - 1)
 #define IL0323_PANEL_FIRST_PAGE 0U
 #define IL0323_PANEL_LAST_PAGE (IL0323_NUMOF_PAGES - 1)
-#define IL0323_BUFFER_SIZE 1280
+#define IL0323_BUFFER_SIZE (IL0323_NUMOF_PAGES * EPD_PANEL_HEIGHT)
+
+/* Area of the panel in pages horizontally and gates vertically, both inclusive */
+struct il0323_window {
+    uint16_t page_start;
+    uint16_t page_end;
+    uint16_t gate_start;
+    uint16_t gate_end;
+};
 
 struct il0323_cfg {
     struct gpio_dt_spec reset;
@@ -45,9 +53,24 @@ struct il0323_cfg {
 
 static uint8_t il0323_pwr[] = DT_INST_PROP(0, pwr);
 
+/* Content of the whole panel as last sent to the controller */
 static uint8_t last_buffer[IL0323_BUFFER_SIZE];
 static bool blanking_on = true;
 static bool init_clear_done = false;
+static uint16_t partial_refresh_count = 0;
+
+static inline int il0323_write_data(const struct il0323_cfg *cfg, const uint8_t *data,
+                                    size_t len) {
+    struct spi_buf buf = {.buf = (uint8_t *)data, .len = len};
+    struct spi_buf_set buf_set = {.buffers = &buf, .count = 1};
+
+    gpio_pin_set_dt(&cfg->dc, 0);
+    if (spi_write_dt(&cfg->spi, &buf_set)) {
+        return -EIO;
+    }
+
+    return 0;
+}
 
 static inline int il0323_write_cmd(const struct il0323_cfg *cfg, uint8_t cmd, uint8_t *data,
                                    size_t len) {
@@ -60,10 +83,52 @@ static inline int il0323_write_cmd(const struct il0323_cfg *cfg, uint8_t cmd, ui
     }
 
     if (data != NULL) {
-        buf.buf = data;
-        buf.len = len;
-        gpio_pin_set_dt(&cfg->dc, 0);
-        if (spi_write_dt(&cfg->spi, &buf_set)) {
+        return il0323_write_data(cfg, data, len);
+    }
+
+    return 0;
+}
+
+/* Send the window's part of a panel sized frame as the data of the given command */
+static int il0323_write_window(const struct il0323_cfg *cfg, uint8_t cmd, const uint8_t *frame,
+                               const struct il0323_window *win) {
+    size_t row_len = win->page_end - win->page_start + 1;
+
+    if (il0323_write_cmd(cfg, cmd, NULL, 0)) {
+        return -EIO;
+    }
+
+    /* Full width rows are contiguous in the frame */
+    if (row_len == IL0323_NUMOF_PAGES) {
+        return il0323_write_data(cfg, &frame[win->gate_start * IL0323_NUMOF_PAGES],
+                                 row_len * (win->gate_end - win->gate_start + 1));
+    }
+
+    for (uint16_t gate = win->gate_start; gate <= win->gate_end; gate++) {
+        if (il0323_write_data(cfg, &frame[gate * IL0323_NUMOF_PAGES + win->page_start],
+                              row_len)) {
+            return -EIO;
+        }
+    }
+
+    return 0;
+}
+
+/* Send the inverse of a panel sized frame, so every pixel is driven by the next refresh */
+static int il0323_write_inverted_frame(const struct il0323_cfg *cfg, uint8_t cmd,
+                                       const uint8_t *frame) {
+    uint8_t row[IL0323_NUMOF_PAGES];
+
+    if (il0323_write_cmd(cfg, cmd, NULL, 0)) {
+        return -EIO;
+    }
+
+    for (int gate = 0; gate < EPD_PANEL_HEIGHT; gate++) {
+        for (int page = 0; page < IL0323_NUMOF_PAGES; page++) {
+            row[page] = ~frame[gate * IL0323_NUMOF_PAGES + page];
+        }
+
+        if (il0323_write_data(cfg, row, sizeof(row))) {
             return -EIO;
         }
     }
@@ -95,39 +160,55 @@ static int il0323_update_display(const struct device *dev) {
     return 0;
 }
 
-static int il0323_write(const struct device *dev, const uint16_t x, const uint16_t y,
-                        const struct display_buffer_descriptor *desc, const void *buf) {
+/*
+ * Refresh the whole panel in normal mode. The old data is the inverse of the new frame so that
+ * every pixel gets driven, which clears the ghosting that builds up with partial refreshes.
+ */
+static int il0323_full_refresh(const struct device *dev) {
     const struct il0323_cfg *cfg = dev->config;
-    uint16_t x_end_idx = x + desc->width - 1;
-    uint16_t y_end_idx = y + desc->height - 1;
-    uint8_t ptl[IL0323_PTL_REG_LENGTH] = {0};
-    size_t buf_len;
 
-    LOG_DBG("x %u, y %u, height %u, width %u, pitch %u", x, y, desc->height, desc->width,
-            desc->pitch);
+    LOG_DBG("Full refresh");
 
-    buf_len = MIN(desc->buf_size, desc->height * desc->width / IL0323_PIXELS_PER_BYTE);
-    __ASSERT(desc->width <= desc->pitch, "Pitch is smaller then width");
-    __ASSERT(buf != NULL, "Buffer is not available");
-    __ASSERT(buf_len != 0U, "Buffer of length zero");
-    __ASSERT(!(desc->width % IL0323_PIXELS_PER_BYTE), "Buffer width not multiple of %d",
-             IL0323_PIXELS_PER_BYTE);
+    if (il0323_write_inverted_frame(cfg, IL0323_CMD_DTM1, last_buffer)) {
+        return -EIO;
+    }
 
-    LOG_DBG("buf_len %d", buf_len);
-    if ((y_end_idx > (EPD_PANEL_HEIGHT - 1)) || (x_end_idx > (EPD_PANEL_WIDTH - 1))) {
-        LOG_ERR("Position out of bounds");
-        return -EINVAL;
+    if (il0323_write_cmd(cfg, IL0323_CMD_DTM2, last_buffer, IL0323_BUFFER_SIZE)) {
+        return -EIO;
     }
 
+    return il0323_update_display(dev);
+}
+
+/* Copy the content of a write into the panel sized frame */
+static void il0323_merge_into_frame(const uint16_t x, const uint16_t y,
+                                    const struct display_buffer_descriptor *desc,
+                                    const uint8_t *src) {
+    uint16_t first_page = x / IL0323_PIXELS_PER_BYTE;
+    uint16_t num_pages = desc->width / IL0323_PIXELS_PER_BYTE;
+    uint16_t src_pitch = desc->pitch / IL0323_PIXELS_PER_BYTE;
+
+    for (uint16_t row = 0; row < desc->height; row++) {
+        memcpy(&last_buffer[(y + row) * IL0323_NUMOF_PAGES + first_page], &src[row * src_pitch],
+               num_pages);
+    }
+}
+
+static int il0323_partial_refresh(const struct device *dev, const struct il0323_window *win,
+                                  const uint16_t x, const uint16_t y,
+                                  const struct display_buffer_descriptor *desc,
+                                  const uint8_t *src) {
+    const struct il0323_cfg *cfg = dev->config;
+    uint8_t ptl[IL0323_PTL_REG_LENGTH] = {0};
+
     /* Setup Partial Window and enable Partial Mode */
-    ptl[IL0323_PTL_HRST_IDX] = x;
-    ptl[IL0323_PTL_HRED_IDX] = x_end_idx;
-    ptl[IL0323_PTL_VRST_IDX] = y;
-    ptl[IL0323_PTL_VRED_IDX] = y_end_idx;
+    ptl[IL0323_PTL_HRST_IDX] = win->page_start * IL0323_PIXELS_PER_BYTE;
+    ptl[IL0323_PTL_HRED_IDX] = (win->page_end + 1) * IL0323_PIXELS_PER_BYTE - 1;
+    ptl[IL0323_PTL_VRST_IDX] = win->gate_start;
+    ptl[IL0323_PTL_VRED_IDX] = win->gate_end;
     ptl[sizeof(ptl) - 1] = IL0323_PTL_PT_SCAN;
     LOG_HEXDUMP_DBG(ptl, sizeof(ptl), "ptl");
 
-    il0323_busy_wait(cfg);
     if (il0323_write_cmd(cfg, IL0323_CMD_PIN, NULL, 0)) {
         return -EIO;
     }
@@ -136,16 +217,17 @@ static int il0323_write(const struct device *dev, const uint16_t x, const uint16
         return -EIO;
     }
 
-    if (il0323_write_cmd(cfg, IL0323_CMD_DTM1, last_buffer, IL0323_BUFFER_SIZE)) {
+    /* The old content of the window lets the controller pick the waveform for each pixel */
+    if (il0323_write_window(cfg, IL0323_CMD_DTM1, last_buffer, win)) {
         return -EIO;
     }
 
-    if (il0323_write_cmd(cfg, IL0323_CMD_DTM2, (uint8_t *)buf, buf_len)) {
+    il0323_merge_into_frame(x, y, desc, src);
+
+    if (il0323_write_window(cfg, IL0323_CMD_DTM2, last_buffer, win)) {
         return -EIO;
     }
 
-    memcpy(last_buffer, (uint8_t *)buf, IL0323_BUFFER_SIZE);
-
     /* Update partial window and disable Partial Mode */
     if (blanking_on == false) {
         if (il0323_update_display(dev)) {
@@ -160,6 +242,79 @@ static int il0323_write(const struct device *dev, const uint16_t x, const uint16
     return 0;
 }
 
+static int il0323_write(const struct device *dev, const uint16_t x, const uint16_t y,
+                        const struct display_buffer_descriptor *desc, const void *buf) {
+    const struct il0323_cfg *cfg = dev->config;
+    const uint8_t *src = buf;
+    uint16_t x_end_idx = x + desc->width - 1;
+    uint16_t y_end_idx = y + desc->height - 1;
+    uint16_t first_page = x / IL0323_PIXELS_PER_BYTE;
+    uint16_t num_pages = desc->width / IL0323_PIXELS_PER_BYTE;
+    uint16_t src_pitch = desc->pitch / IL0323_PIXELS_PER_BYTE;
+    struct il0323_window dirty = {
+        .page_start = UINT16_MAX,
+        .page_end = 0,
+        .gate_start = UINT16_MAX,
+        .gate_end = 0,
+    };
+    size_t buf_len;
+
+    LOG_DBG("x %u, y %u, height %u, width %u, pitch %u", x, y, desc->height, desc->width,
+            desc->pitch);
+
+    buf_len = MIN(desc->buf_size, desc->height * desc->width / IL0323_PIXELS_PER_BYTE);
+    __ASSERT(desc->width <= desc->pitch, "Pitch is smaller then width");
+    __ASSERT(buf != NULL, "Buffer is not available");
+    __ASSERT(buf_len != 0U, "Buffer of length zero");
+    __ASSERT(!(desc->width % IL0323_PIXELS_PER_BYTE), "Buffer width not multiple of %d",
+             IL0323_PIXELS_PER_BYTE);
+    __ASSERT(!(x % IL0323_PIXELS_PER_BYTE), "X not multiple of %d", IL0323_PIXELS_PER_BYTE);
+
+    LOG_DBG("buf_len %d", buf_len);
+    if ((y_end_idx > (EPD_PANEL_HEIGHT - 1)) || (x_end_idx > (EPD_PANEL_WIDTH - 1))) {
+        LOG_ERR("Position out of bounds");
+        return -EINVAL;
+    }
+
+    /* Find the bounding box of the bytes that differ from what the panel shows */
+    for (uint16_t row = 0; row < desc->height; row++) {
+        const uint8_t *src_row = &src[row * src_pitch];
+        const uint8_t *last_row = &last_buffer[(y + row) * IL0323_NUMOF_PAGES + first_page];
+
+        for (uint16_t page = 0; page < num_pages; page++) {
+            if (src_row[page] != last_row[page]) {
+                dirty.page_start = MIN(dirty.page_start, first_page + page);
+                dirty.page_end = MAX(dirty.page_end, first_page + page);
+                dirty.gate_start = MIN(dirty.gate_start, y + row);
+                dirty.gate_end = MAX(dirty.gate_end, y + row);
+            }
+        }
+    }
+
+    if (dirty.gate_start == UINT16_MAX) {
+        LOG_DBG("Content unchanged, skipping refresh");
+        return 0;
+    }
+
+    LOG_DBG("Dirty pages %u-%u, gates %u-%u", dirty.page_start, dirty.page_end,
+            dirty.gate_start, dirty.gate_end);
+
+    il0323_busy_wait(cfg);
+
+    if (!blanking_on && CONFIG_IL0323_FULL_REFRESH_INTERVAL > 0 &&
+        partial_refresh_count >= CONFIG_IL0323_FULL_REFRESH_INTERVAL) {
+        partial_refresh_count = 0;
+        il0323_merge_into_frame(x, y, desc, src);
+        return il0323_full_refresh(dev);
+    }
+
+    if (!blanking_on) {
+        partial_refresh_count++;
+    }
+
+    return il0323_partial_refresh(dev, &dirty, x, y, desc, src);
+}
+
 static int il0323_read(const struct device *dev, const uint16_t x, const uint16_t y,
                        const struct display_buffer_descriptor *desc, void *buf) {
     LOG_ERR("not supported");
@@ -167,26 +322,18 @@ static int il0323_read(const struct device *dev, const uint16_t x, const uint16_
 }
 
 static int il0323_clear_and_write_buffer(const struct device *dev, uint8_t pattern, bool update) {
-    struct display_buffer_descriptor desc = {
-        .buf_size = IL0323_NUMOF_PAGES,
-        .width = EPD_PANEL_WIDTH,
-        .height = 1,
-        .pitch = EPD_PANEL_WIDTH,
-    };
-    uint8_t *line;
+    const struct il0323_cfg *cfg = dev->config;
 
-    line = k_malloc(IL0323_NUMOF_PAGES);
-    if (line == NULL) {
-        LOG_ERR("Failed to allocate memory for the clear");
-        return -ENOMEM;
+    /* Write the whole frame in normal mode instead of one partial window per line */
+    if (il0323_write_cmd(cfg, IL0323_CMD_DTM1, last_buffer, IL0323_BUFFER_SIZE)) {
+        return -EIO;
     }
 
-    memset(line, pattern, IL0323_NUMOF_PAGES);
-    for (int i = 0; i < EPD_PANEL_HEIGHT; i++) {
-        il0323_write(dev, 0, i, &desc, line);
-    }
+    memset(last_buffer, pattern, IL0323_BUFFER_SIZE);
 
-    k_free(line);
+    if (il0323_write_cmd(cfg, IL0323_CMD_DTM2, last_buffer, IL0323_BUFFER_SIZE)) {
+        return -EIO;
+    }
 
     if (update == true) {
         if (il0323_update_display(dev)) {
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2025 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_led_strip_mock
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/led_strip.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+static int led_strip_mock_update_rgb(const struct device *dev, struct led_rgb *pixels,
+                                     size_t num_pixels) {
+    for (size_t i = 0; i < num_pixels; i++) {
+        LOG_DBG("pixel %zu: %d %d %d", i, pixels[i].r, pixels[i].g, pixels[i].b);
+    }
+
+    return 0;
+}
+
+static int led_strip_mock_update_channels(const struct device *dev, uint8_t *channels,
+                                          size_t num_channels) {
+    return -ENOTSUP;
+}
+
+static const struct led_strip_driver_api led_strip_mock_api = {
+    .update_rgb = led_strip_mock_update_rgb,
+    .update_channels = led_strip_mock_update_channels,
+};
+
+#define LED_STRIP_MOCK_INST(n)                                                                     \
+    DEVICE_DT_INST_DEFINE(n, NULL, NULL, NULL, NULL, POST_KERNEL,                                  \
+                          CONFIG_LED_STRIP_INIT_PRIORITY, &led_strip_mock_api);
+
+DT_INST_FOREACH_STATUS_OKAY(LED_STRIP_MOCK_INST)
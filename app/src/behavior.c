@@ -8,6 +8,7 @@
 #include <zephyr/init.h>
 #include <zephyr/sys/crc.h>
 #include <zephyr/sys/util_macro.h>
+#include <stdlib.h>
 #include <string.h>
 
 #if IS_ENABLED(CONFIG_ZMK_BEHAVIOR_LOCAL_IDS) &&                                                   \
@@ -261,11 +262,111 @@ int zmk_behavior_validate_binding(const struct zmk_behavior_binding *binding) {
 
 #if IS_ENABLED(CONFIG_ZMK_BEHAVIOR_LOCAL_IDS)
 
+// Once the local IDs are known, the map section is sorted by device name and each entry's
+// by_local_id gives the order by local ID, so both lookups are binary searches.
+static bool local_id_index_ready;
+
+static int compare_local_id_map_names(const void *a, const void *b) {
+    const struct zmk_behavior_local_id_map *map_a = a;
+    const struct zmk_behavior_local_id_map *map_b = b;
+
+    return strcmp(map_a->device->name, map_b->device->name);
+}
+
+static void build_local_id_index(void) {
+    struct zmk_behavior_local_id_map *items;
+    ptrdiff_t count;
+
+    local_id_index_ready = false;
+
+    STRUCT_SECTION_GET(zmk_behavior_local_id_map, 0, &items);
+    STRUCT_SECTION_COUNT(zmk_behavior_local_id_map, &count);
+
+    qsort(items, count, sizeof(items[0]), compare_local_id_map_names);
+
+    // Insertion sort of the permutation, which is quick enough for the few hundred behaviors of
+    // even large keymaps and only runs when local IDs are assigned.
+    for (ptrdiff_t i = 0; i < count; i++) {
+        uint16_t idx = i;
+        ptrdiff_t j = i;
+
+        while (j > 0 && items[items[j - 1].by_local_id].local_id > items[idx].local_id) {
+            items[j].by_local_id = items[j - 1].by_local_id;
+            j--;
+        }
+
+        items[j].by_local_id = idx;
+    }
+
+    local_id_index_ready = true;
+}
+
+static struct zmk_behavior_local_id_map *find_local_id_map_by_name(const char *name) {
+    struct zmk_behavior_local_id_map *items;
+    ptrdiff_t count;
+
+    STRUCT_SECTION_GET(zmk_behavior_local_id_map, 0, &items);
+    STRUCT_SECTION_COUNT(zmk_behavior_local_id_map, &count);
+
+    ptrdiff_t lo = 0, hi = count;
+    while (lo < hi) {
+        ptrdiff_t mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(items[mid].device->name, name);
+
+        if (cmp == 0) {
+            return &items[mid];
+        } else if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return NULL;
+}
+
+static struct zmk_behavior_local_id_map *
+find_ready_local_id_map_by_id(zmk_behavior_local_id_t local_id) {
+    struct zmk_behavior_local_id_map *items;
+    ptrdiff_t count;
+
+    STRUCT_SECTION_GET(zmk_behavior_local_id_map, 0, &items);
+    STRUCT_SECTION_COUNT(zmk_behavior_local_id_map, &count);
+
+    ptrdiff_t lo = 0, hi = count;
+    while (lo < hi) {
+        ptrdiff_t mid = lo + (hi - lo) / 2;
+
+        if (items[items[mid].by_local_id].local_id < local_id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Devices that aren't ready can share an unassigned ID, so skip past them
+    for (; lo < count && items[items[lo].by_local_id].local_id == local_id; lo++) {
+        struct zmk_behavior_local_id_map *item = &items[items[lo].by_local_id];
+
+        if (z_device_is_ready(item->device)) {
+            return item;
+        }
+    }
+
+    return NULL;
+}
+
 zmk_behavior_local_id_t zmk_behavior_get_local_id(const char *name) {
     if (!name) {
         return UINT16_MAX;
     }
 
+    if (local_id_index_ready) {
+        const struct zmk_behavior_local_id_map *item = find_local_id_map_by_name(name);
+
+        return (item && z_device_is_ready(item->device)) ? item->local_id : UINT16_MAX;
+    }
+
     STRUCT_SECTION_FOREACH(zmk_behavior_local_id_map, item) {
         if (z_device_is_ready(item->device) && strcmp(item->device->name, name) == 0) {
             return item->local_id;
@@ -276,6 +377,12 @@ zmk_behavior_local_id_t zmk_behavior_get_local_id(const char *name) {
 }
 
 const char *zmk_behavior_find_behavior_name_from_local_id(zmk_behavior_local_id_t local_id) {
+    if (local_id_index_ready) {
+        const struct zmk_behavior_local_id_map *item = find_ready_local_id_map_by_id(local_id);
+
+        return item ? item->device->name : NULL;
+    }
+
     STRUCT_SECTION_FOREACH(zmk_behavior_local_id_map, item) {
         if (z_device_is_ready(item->device) && item->local_id == local_id) {
             return item->device->name;
@@ -292,6 +399,8 @@ static int behavior_local_id_init(void) {
         item->local_id = crc16_ansi(item->device->name, strlen(item->device->name));
     }
 
+    build_local_id_index();
+
     return 0;
 }
 
@@ -364,6 +473,8 @@ static int behavior_handle_commit(void) {
         settings_save_one(setting_name, device_name, strlen(device_name));
     }
 
+    build_local_id_index();
+
     return 0;
 }
 
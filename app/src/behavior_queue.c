@@ -6,6 +6,7 @@
 
 #include <zmk/behavior_queue.h>
 #include <zmk/behavior.h>
+#include <zmk/telemetry.h>
 
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
@@ -74,6 +75,9 @@ int zmk_behavior_queue_add(const struct zmk_behavior_binding_event *event,
         return ret;
     }
 
+    zmk_telemetry_record_queue_depth(ZMK_TELEMETRY_QUEUE_BEHAVIOR,
+                                     k_msgq_num_used_get(&zmk_behavior_queue_msgq));
+
     if (!k_work_delayable_is_pending(&queue_work)) {
         behavior_queue_process_next(&queue_work.work);
     }
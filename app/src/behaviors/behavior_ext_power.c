@@ -13,6 +13,8 @@
 
 #include <dt-bindings/zmk/ext_power.h>
 
+#include <zmk/rgb_underglow.h>
+
 #include <zephyr/logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
@@ -34,6 +36,19 @@ on_keymap_binding_convert_central_state_dependent_params(struct zmk_behavior_bin
     return 0;
 }
 
+static int enable_ext_power(const struct device *ext_power) {
+    int ret = ext_power_enable(ext_power);
+
+#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW)
+    // Frames sent while the strip was unpowered were lost
+    if (ret == 0) {
+        zmk_rgb_underglow_refresh();
+    }
+#endif
+
+    return ret;
+}
+
 static int on_keymap_binding_pressed(struct zmk_behavior_binding *binding,
                                      struct zmk_behavior_binding_event event) {
     const struct device *ext_power = device_get_binding("EXT_POWER");
@@ -46,12 +61,12 @@ static int on_keymap_binding_pressed(struct zmk_behavior_binding *binding,
     case EXT_POWER_OFF_CMD:
         return ext_power_disable(ext_power);
     case EXT_POWER_ON_CMD:
-        return ext_power_enable(ext_power);
+        return enable_ext_power(ext_power);
     case EXT_POWER_TOGGLE_CMD:
         if (ext_power_get(ext_power) > 0)
             return ext_power_disable(ext_power);
         else
-            return ext_power_enable(ext_power);
+            return enable_ext_power(ext_power);
     default:
         LOG_ERR("Unknown ext_power command: %d", binding->param1);
     }
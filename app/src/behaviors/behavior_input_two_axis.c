@@ -14,6 +14,7 @@
 
 #include <zmk/behavior.h>
 #include <dt-bindings/zmk/pointing.h>
+#include <zmk/pointing/curve.h>
 
 #if IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
 #include <zmk/pointing/resolution_multipliers.h>
@@ -21,13 +22,22 @@
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+// Curve values are fractions of the max speed, with ACCEL_CURVE_ONE being the max speed itself
+#define ACCEL_CURVE_SHIFT 15
+#define ACCEL_CURVE_ONE (1 << ACCEL_CURVE_SHIFT)
+
+// Movement is tracked in 1/65536ths of a count, so sub-count remainders carry over between ticks
+#define MOVE_FRAC_SHIFT 16
+// Signed, so it can be used with negative movement without converting it to unsigned
+#define MOVE_FRAC_ONE ((int64_t)BIT(MOVE_FRAC_SHIFT))
+
 struct vector2d {
-    float x;
-    float y;
+    int16_t x;
+    int16_t y;
 };
 
 struct movement_state_1d {
-    float remainder;
+    int32_t remainder;
     int16_t speed;
     int64_t start_time;
 };
@@ -42,6 +52,9 @@ struct behavior_input_two_axis_data {
     const struct device *dev;
 
     struct movement_state_2d state;
+
+    // Speed fractions sampled over time-to-max-speed-ms
+    uint16_t accel_curve[ZMK_POINTING_CURVE_POINTS];
 };
 
 struct behavior_input_two_axis_config {
@@ -54,21 +67,11 @@ struct behavior_input_two_axis_config {
     // acceleration exponent 1: uniform acceleration
     // acceleration exponent 2: uniform jerk
     uint8_t acceleration_exponent;
+    // Optional custom curve, in permille of the max speed, which replaces the exponent curve
+    uint8_t acceleration_curve_len;
+    const uint16_t *acceleration_curve;
 };
 
-#if CONFIG_MINIMAL_LIBC
-static float powf(float base, float exponent) {
-    // poor man's power implementation rounds the exponent down to the nearest integer.
-    float power = 1.0f;
-    for (; exponent >= 1.0f; exponent--) {
-        power = power * base;
-    }
-    return power;
-}
-#else
-#include <math.h>
-#endif
-
 static int64_t ticks_since_start(int64_t start, int64_t now, int64_t delay) {
     if (start == 0) {
         return 0;
@@ -108,13 +111,16 @@ static inline uint8_t get_acceleration_exponent(const struct behavior_input_two_
 
 #endif // IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
 
-static float speed(const struct behavior_input_two_axis_config *config, uint16_t code,
-                   float max_speed, int64_t duration_ticks) {
+// Returns the fraction of the max speed reached after the given time, see ACCEL_CURVE_ONE
+static uint32_t speed_fraction(const struct behavior_input_two_axis_config *config,
+                               const struct behavior_input_two_axis_data *data, uint16_t code,
+                               int64_t duration_ticks) {
     uint8_t accel_exp = get_acceleration_exponent(config, code);
+    int64_t duration_ms = k_ticks_to_ms_floor64(duration_ticks);
 
-    if ((1000 * duration_ticks / CONFIG_SYS_CLOCK_TICKS_PER_SEC) > config->time_to_max_speed_ms ||
-        config->time_to_max_speed_ms == 0 || accel_exp == 0) {
-        return max_speed;
+    if (duration_ms > config->time_to_max_speed_ms || config->time_to_max_speed_ms == 0 ||
+        accel_exp == 0) {
+        return ACCEL_CURVE_ONE;
     }
 
     // Calculate the speed based on MouseKeysAccel
@@ -123,43 +129,55 @@ static float speed(const struct behavior_input_two_axis_config *config, uint16_t
         return 0;
     }
 
-    float time_fraction = (float)(1000 * duration_ticks / CONFIG_SYS_CLOCK_TICKS_PER_SEC) /
-                          config->time_to_max_speed_ms;
-    return max_speed * powf(time_fraction, accel_exp);
-}
+    uint32_t pos = (uint32_t)duration_ms * ZMK_POINTING_CURVE_SEGMENTS;
+    uint32_t idx = pos / config->time_to_max_speed_ms;
+    uint32_t rem = pos % config->time_to_max_speed_ms;
+
+    if (idx >= ZMK_POINTING_CURVE_SEGMENTS) {
+        return data->accel_curve[ZMK_POINTING_CURVE_SEGMENTS];
+    }
+
+    int32_t from = data->accel_curve[idx];
+    int32_t to = data->accel_curve[idx + 1];
 
-static void track_remainder(float *move, float *remainder) {
-    float new_move = *move + *remainder;
-    *remainder = new_move - (int)new_move;
-    *move = (int)new_move;
+    return from + (int64_t)(to - from) * rem / config->time_to_max_speed_ms;
 }
 
-static float update_movement_1d(const struct behavior_input_two_axis_config *config, uint16_t code,
-                                struct movement_state_1d *state, int64_t now) {
-    float move = 0;
+static int16_t update_movement_1d(const struct behavior_input_two_axis_config *config,
+                                  const struct behavior_input_two_axis_data *data, uint16_t code,
+                                  struct movement_state_1d *state, int64_t now) {
     if (state->speed == 0) {
         state->remainder = 0;
-        return move;
+        return 0;
     }
 
     int64_t move_duration = ticks_since_start(state->start_time, now, config->delay_ms);
-    LOG_DBG("Calculated speed: %f", speed(config, code, state->speed, move_duration));
-    move =
-        (move_duration > 0)
-            ? (speed(config, code, state->speed, move_duration) * config->trigger_period_ms / 1000)
-            : 0;
+    if (move_duration <= 0) {
+        return 0;
+    }
 
-    track_remainder(&(move), &(state->remainder));
+    uint32_t fraction = speed_fraction(config, data, code, move_duration);
+    LOG_DBG("Calculated speed fraction: %d/%d", fraction, ACCEL_CURVE_ONE);
 
-    return move;
+    int64_t move = (int64_t)state->speed * fraction * config->trigger_period_ms *
+                   (int64_t)BIT(MOVE_FRAC_SHIFT - ACCEL_CURVE_SHIFT);
+    move = move / 1000 + state->remainder;
+
+    // Truncate towards zero, keeping what's left for the next tick
+    int64_t whole = move / MOVE_FRAC_ONE;
+    state->remainder = move - whole * MOVE_FRAC_ONE;
+
+    return CLAMP(whole, INT16_MIN, INT16_MAX);
 }
+
 static struct vector2d update_movement_2d(const struct behavior_input_two_axis_config *config,
+                                          const struct behavior_input_two_axis_data *data,
                                           struct movement_state_2d *state, int64_t now) {
     struct vector2d move = {0};
 
     move = (struct vector2d){
-        .x = update_movement_1d(config, config->x_code, &state->x, now),
-        .y = update_movement_1d(config, config->y_code, &state->y, now),
+        .x = update_movement_1d(config, data, config->x_code, &state->x, now),
+        .y = update_movement_1d(config, data, config->y_code, &state->y, now),
     };
 
     return move;
@@ -187,18 +205,16 @@ static void tick_work_cb(struct k_work *work) {
     // LOG_INF("x start: %llu, y start: %llu, current timestamp: %llu", data->state.x.start_time,
     //         data->state.y.start_time, timestamp);
 
-    struct vector2d move = update_movement_2d(cfg, &data->state, timestamp);
+    struct vector2d move = update_movement_2d(cfg, data, &data->state, timestamp);
 
     int ret = 0;
     bool have_x = is_non_zero_1d_movement(move.x);
     bool have_y = is_non_zero_1d_movement(move.y);
     if (have_x) {
-        ret = input_report_rel(dev, cfg->x_code, (int16_t)CLAMP(move.x, INT16_MIN, INT16_MAX),
-                               !have_y, K_NO_WAIT);
+        ret = input_report_rel(dev, cfg->x_code, move.x, !have_y, K_NO_WAIT);
     }
     if (have_y) {
-        ret = input_report_rel(dev, cfg->y_code, (int16_t)CLAMP(move.y, INT16_MIN, INT16_MAX), true,
-                               K_NO_WAIT);
+        ret = input_report_rel(dev, cfg->y_code, move.y, true, K_NO_WAIT);
     }
 
     if (should_be_working(data)) {
@@ -249,8 +265,22 @@ int behavior_input_two_axis_adjust_speed(const struct device *dev, int16_t dx, i
 
 static int behavior_input_two_axis_init(const struct device *dev) {
     struct behavior_input_two_axis_data *data = dev->data;
+    const struct behavior_input_two_axis_config *cfg = dev->config;
 
     data->dev = dev;
+
+    if (cfg->acceleration_curve_len > 0) {
+        zmk_pointing_curve_build_from_points(data->accel_curve, cfg->acceleration_curve,
+                                             cfg->acceleration_curve_len, ACCEL_CURVE_ONE);
+
+        // Moving faster than the max speed isn't supported
+        for (int i = 0; i < ZMK_POINTING_CURVE_POINTS; i++) {
+            data->accel_curve[i] = MIN(data->accel_curve[i], ACCEL_CURVE_ONE);
+        }
+    } else {
+        zmk_pointing_curve_build_exponent(data->accel_curve, 0, 1000, cfg->acceleration_exponent,
+                                          ACCEL_CURVE_ONE);
+    }
     k_work_init_delayable(&data->tick_work, tick_work_cb);
 
     return 0;
@@ -286,7 +316,18 @@ static int on_keymap_binding_released(struct zmk_behavior_binding *binding,
 static const struct behavior_driver_api behavior_input_two_axis_driver_api = {
     .binding_pressed = on_keymap_binding_pressed, .binding_released = on_keymap_binding_released};
 
+#define ITA_CURVE(n)                                                                               \
+    COND_CODE_1(DT_INST_NODE_HAS_PROP(n, acceleration_curve),                                      \
+                (static const uint16_t behavior_input_two_axis_curve_##n[] =                       \
+                     DT_INST_PROP(n, acceleration_curve);                                          \
+                 BUILD_ASSERT(DT_INST_PROP_LEN(n, acceleration_curve) >= 2,                        \
+                              "An acceleration curve needs at least two points");                  \
+                 BUILD_ASSERT(DT_INST_PROP_LEN(n, acceleration_curve) <= UINT8_MAX,                \
+                              "An acceleration curve can have at most 255 points");),              \
+                ())
+
 #define ITA_INST(n)                                                                                \
+    ITA_CURVE(n)                                                                                   \
     static struct behavior_input_two_axis_data behavior_input_two_axis_data_##n = {};              \
     static struct behavior_input_two_axis_config behavior_input_two_axis_config_##n = {            \
         .x_code = DT_INST_PROP(n, x_input_code),                                                   \
@@ -295,6 +336,9 @@ static const struct behavior_driver_api behavior_input_two_axis_driver_api = {
         .delay_ms = DT_INST_PROP_OR(n, delay_ms, 0),                                               \
         .time_to_max_speed_ms = DT_INST_PROP(n, time_to_max_speed_ms),                             \
         .acceleration_exponent = DT_INST_PROP_OR(n, acceleration_exponent, 1),                     \
+        .acceleration_curve_len = DT_INST_PROP_LEN_OR(n, acceleration_curve, 0),                   \
+        .acceleration_curve = COND_CODE_1(DT_INST_NODE_HAS_PROP(n, acceleration_curve),            \
+                                          (behavior_input_two_axis_curve_##n), (NULL)),            \
     };                                                                                             \
     BEHAVIOR_DT_INST_DEFINE(                                                                       \
         n, behavior_input_two_axis_init, NULL, &behavior_input_two_axis_data_##n,                  \
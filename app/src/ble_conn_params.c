@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2025 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/sys/atomic.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/ble/conn_params.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/position_state_changed.h>
+#include <zmk/events/sensor_event.h>
+
+#if IS_ENABLED(CONFIG_ZMK_POINTING)
+#include <zephyr/input/input.h>
+#endif
+
+#define IDLE_TIMEOUT_MS CONFIG_ZMK_BLE_CONN_PARAMS_IDLE_TIMEOUT
+#define LONG_IDLE_TIMEOUT_MS CONFIG_ZMK_BLE_CONN_PARAMS_LONG_IDLE_TIMEOUT
+
+// The supervision timeout must be longer than (1 + latency) * interval * 2
+#define CONN_PARAMS_VALID(max_int, latency, timeout) ((timeout) * 4 > (1 + (latency)) * (max_int))
+
+// Longest time between connection events the peripheral has to listen to
+#define EFFECTIVE_INTERVAL(max_int, latency) ((1 + (latency)) * (max_int))
+
+BUILD_ASSERT(CONN_PARAMS_VALID(CONFIG_ZMK_BLE_CONN_PARAMS_IDLE_MAX_INT,
+                               CONFIG_ZMK_BLE_CONN_PARAMS_IDLE_LATENCY,
+                               CONFIG_ZMK_BLE_CONN_PARAMS_TIMEOUT),
+                 "Idle connection latency and interval are too long for the supervision timeout");
+BUILD_ASSERT(CONN_PARAMS_VALID(CONFIG_ZMK_BLE_CONN_PARAMS_LONG_IDLE_MAX_INT,
+                               CONFIG_ZMK_BLE_CONN_PARAMS_LONG_IDLE_LATENCY,
+                               CONFIG_ZMK_BLE_CONN_PARAMS_TIMEOUT),
+                 "Long idle connection latency and interval are too long for the supervision "
+                 "timeout");
+BUILD_ASSERT(LONG_IDLE_TIMEOUT_MS > IDLE_TIMEOUT_MS,
+             "Long idle timeout must be longer than the idle timeout");
+BUILD_ASSERT(EFFECTIVE_INTERVAL(CONFIG_ZMK_BLE_CONN_PARAMS_LONG_IDLE_MAX_INT,
+                                CONFIG_ZMK_BLE_CONN_PARAMS_LONG_IDLE_LATENCY) >=
+                 EFFECTIVE_INTERVAL(CONFIG_ZMK_BLE_CONN_PARAMS_IDLE_MAX_INT,
+                                    CONFIG_ZMK_BLE_CONN_PARAMS_IDLE_LATENCY),
+             "Long idle parameters must not wake the radio more often than the idle ones");
+
+static const struct bt_le_conn_param host_conn_params[] = {
+    [ZMK_BLE_CONN_PARAMS_PROFILE_ACTIVE] = BT_LE_CONN_PARAM_INIT(
+        CONFIG_BT_PERIPHERAL_PREF_MIN_INT, CONFIG_BT_PERIPHERAL_PREF_MAX_INT,
+        CONFIG_BT_PERIPHERAL_PREF_LATENCY, CONFIG_BT_PERIPHERAL_PREF_TIMEOUT),
+    [ZMK_BLE_CONN_PARAMS_PROFILE_IDLE] = BT_LE_CONN_PARAM_INIT(
+        CONFIG_ZMK_BLE_CONN_PARAMS_IDLE_MIN_INT, CONFIG_ZMK_BLE_CONN_PARAMS_IDLE_MAX_INT,
+        CONFIG_ZMK_BLE_CONN_PARAMS_IDLE_LATENCY, CONFIG_ZMK_BLE_CONN_PARAMS_TIMEOUT),
+    [ZMK_BLE_CONN_PARAMS_PROFILE_LONG_IDLE] = BT_LE_CONN_PARAM_INIT(
+        CONFIG_ZMK_BLE_CONN_PARAMS_LONG_IDLE_MIN_INT, CONFIG_ZMK_BLE_CONN_PARAMS_LONG_IDLE_MAX_INT,
+        CONFIG_ZMK_BLE_CONN_PARAMS_LONG_IDLE_LATENCY, CONFIG_ZMK_BLE_CONN_PARAMS_TIMEOUT),
+};
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE) && IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
+
+// The split link keeps the parameters it was created with while active
+static const struct bt_le_conn_param split_conn_params[] = {
+    [ZMK_BLE_CONN_PARAMS_PROFILE_ACTIVE] =
+        BT_LE_CONN_PARAM_INIT(CONFIG_ZMK_SPLIT_BLE_PREF_INT, CONFIG_ZMK_SPLIT_BLE_PREF_INT,
+                              CONFIG_ZMK_SPLIT_BLE_PREF_LATENCY, CONFIG_ZMK_SPLIT_BLE_PREF_TIMEOUT),
+    [ZMK_BLE_CONN_PARAMS_PROFILE_IDLE] = BT_LE_CONN_PARAM_INIT(
+        CONFIG_ZMK_BLE_CONN_PARAMS_IDLE_MIN_INT, CONFIG_ZMK_BLE_CONN_PARAMS_IDLE_MAX_INT,
+        CONFIG_ZMK_BLE_CONN_PARAMS_IDLE_LATENCY, CONFIG_ZMK_BLE_CONN_PARAMS_TIMEOUT),
+    [ZMK_BLE_CONN_PARAMS_PROFILE_LONG_IDLE] = BT_LE_CONN_PARAM_INIT(
+        CONFIG_ZMK_BLE_CONN_PARAMS_LONG_IDLE_MIN_INT, CONFIG_ZMK_BLE_CONN_PARAMS_LONG_IDLE_MAX_INT,
+        CONFIG_ZMK_BLE_CONN_PARAMS_LONG_IDLE_LATENCY, CONFIG_ZMK_BLE_CONN_PARAMS_TIMEOUT),
+};
+
+#endif
+
+static enum zmk_ble_conn_params_profile current_profile = ZMK_BLE_CONN_PARAMS_PROFILE_ACTIVE;
+static int64_t profile_entered_at;
+static atomic_t last_activity;
+
+// Host link latency to use while the active profile is held, or -1 while it isn't
+static atomic_t held_host_latency = ATOMIC_INIT(-1);
+
+static struct zmk_ble_conn_params_stats stats;
+
+static int params_for_conn(const struct bt_conn_info *info, struct bt_le_conn_param *param) {
+    switch (info->role) {
+    case BT_CONN_ROLE_PERIPHERAL: {
+        *param = host_conn_params[current_profile];
+
+        atomic_val_t held_latency = atomic_get(&held_host_latency);
+        if (held_latency >= 0) {
+            param->latency = held_latency;
+        }
+
+        return 0;
+    }
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE) && IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
+    case BT_CONN_ROLE_CENTRAL:
+        *param = split_conn_params[current_profile];
+        return 0;
+#endif
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static void apply_profile_to_conn(struct bt_conn *conn, void *data) {
+    struct bt_conn_info info;
+
+    if (bt_conn_get_info(conn, &info) < 0 || info.state != BT_CONN_STATE_CONNECTED) {
+        return;
+    }
+
+    struct bt_le_conn_param param;
+    if (params_for_conn(&info, &param) < 0) {
+        return;
+    }
+
+    if (info.le.interval >= param.interval_min && info.le.interval <= param.interval_max &&
+        info.le.latency == param.latency) {
+        return;
+    }
+
+    stats.update_requests++;
+
+    int err = bt_conn_le_param_update(conn, &param);
+    if (err < 0 && err != -EALREADY) {
+        LOG_WRN("Failed to request connection parameter update (%d)", err);
+        stats.update_failures++;
+    }
+}
+
+static void set_profile(enum zmk_ble_conn_params_profile profile) {
+    if (profile == current_profile) {
+        return;
+    }
+
+    int64_t now = k_uptime_get();
+
+    LOG_DBG("Switching connection parameter profile from %d to %d", current_profile, profile);
+
+    stats.time_in_profile[current_profile] += now - profile_entered_at;
+    stats.transitions++;
+
+    current_profile = profile;
+    profile_entered_at = now;
+
+    bt_conn_foreach(BT_CONN_TYPE_LE, apply_profile_to_conn, NULL);
+}
+
+static void idle_work_cb(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(idle_work, idle_work_cb);
+
+static void idle_work_cb(struct k_work *work) {
+    if (atomic_get(&held_host_latency) >= 0) {
+        if (current_profile == ZMK_BLE_CONN_PARAMS_PROFILE_ACTIVE) {
+            // The held latency may differ from the one the links currently use
+            bt_conn_foreach(BT_CONN_TYPE_LE, apply_profile_to_conn, NULL);
+        } else {
+            set_profile(ZMK_BLE_CONN_PARAMS_PROFILE_ACTIVE);
+        }
+
+        // Keeps the work pending, so activity while held doesn't run it on every event
+        k_work_reschedule(&idle_work, K_MSEC(IDLE_TIMEOUT_MS));
+        return;
+    }
+
+    uint32_t idle_time = k_uptime_get_32() - (uint32_t)atomic_get(&last_activity);
+
+    if (idle_time >= LONG_IDLE_TIMEOUT_MS) {
+        set_profile(ZMK_BLE_CONN_PARAMS_PROFILE_LONG_IDLE);
+    } else if (idle_time >= IDLE_TIMEOUT_MS) {
+        set_profile(ZMK_BLE_CONN_PARAMS_PROFILE_IDLE);
+        k_work_reschedule(&idle_work, K_MSEC(LONG_IDLE_TIMEOUT_MS - idle_time));
+    } else {
+        set_profile(ZMK_BLE_CONN_PARAMS_PROFILE_ACTIVE);
+        k_work_reschedule(&idle_work, K_MSEC(IDLE_TIMEOUT_MS - idle_time));
+    }
+}
+
+static void note_activity(void) {
+    atomic_set(&last_activity, (atomic_val_t)k_uptime_get_32());
+
+    // Only leaving an idle profile needs the work queue, so steady typing or pointer motion
+    // costs a single atomic store per event.
+    if (current_profile != ZMK_BLE_CONN_PARAMS_PROFILE_ACTIVE ||
+        !k_work_delayable_is_pending(&idle_work)) {
+        k_work_reschedule(&idle_work, K_NO_WAIT);
+    }
+}
+
+enum zmk_ble_conn_params_profile zmk_ble_conn_params_get_profile(void) { return current_profile; }
+
+void zmk_ble_conn_params_hold_active(uint16_t host_latency) {
+    atomic_set(&held_host_latency, host_latency);
+    k_work_reschedule(&idle_work, K_NO_WAIT);
+}
+
+void zmk_ble_conn_params_release_active(void) {
+    atomic_set(&held_host_latency, -1);
+    // Counts as activity, so the idle timeouts start over from the release
+    note_activity();
+    k_work_reschedule(&idle_work, K_NO_WAIT);
+}
+
+int zmk_ble_conn_params_get_stats(struct zmk_ble_conn_params_stats *out) {
+    *out = stats;
+    out->time_in_profile[current_profile] += k_uptime_get() - profile_entered_at;
+
+    return 0;
+}
+
+static void conn_params_connected(struct bt_conn *conn, uint8_t err) {
+    if (err) {
+        return;
+    }
+
+    // Treat a new connection as activity, so it gets through discovery and pairing with fast
+    // parameters and is moved to the idle profile by the usual timeout afterwards.
+    note_activity();
+}
+
+static void conn_params_le_param_updated(struct bt_conn *conn, uint16_t interval,
+                                         uint16_t latency, uint16_t timeout) {
+    LOG_DBG("Connection parameters for profile %d now interval %d latency %d timeout %d",
+            current_profile, interval, latency, timeout);
+}
+
+static struct bt_conn_cb conn_params_conn_callbacks = {
+    .connected = conn_params_connected,
+    .le_param_updated = conn_params_le_param_updated,
+};
+
+static int conn_params_listener(const zmk_event_t *eh) {
+    note_activity();
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(ble_conn_params, conn_params_listener);
+ZMK_SUBSCRIPTION(ble_conn_params, zmk_position_state_changed);
+ZMK_SUBSCRIPTION(ble_conn_params, zmk_sensor_event);
+
+#if IS_ENABLED(CONFIG_ZMK_POINTING)
+
+static void conn_params_input_listener(struct input_event *ev) { note_activity(); }
+
+INPUT_CALLBACK_DEFINE(NULL, conn_params_input_listener);
+
+#endif
+
+static int zmk_ble_conn_params_init(void) {
+    profile_entered_at = k_uptime_get();
+    atomic_set(&last_activity, (atomic_val_t)k_uptime_get_32());
+
+    bt_conn_cb_register(&conn_params_conn_callbacks);
+    k_work_schedule(&idle_work, K_MSEC(IDLE_TIMEOUT_MS));
+
+    return 0;
+}
+
+SYS_INIT(zmk_ble_conn_params_init, APPLICATION, CONFIG_ZMK_BLE_INIT_PRIORITY);
@@ -50,7 +50,7 @@ struct combo_cfg {
     int16_t key_position_len;
     int16_t require_prior_idle_ms;
     int32_t timeout_ms;
-    uint32_t layer_mask;
+    zmk_keymap_layers_state_t layer_mask;
     struct zmk_behavior_binding behavior;
     // if slow release is set, the combo releases when the last key is released.
     // otherwise, the combo releases when the first key is released.
@@ -72,6 +72,12 @@ struct active_combo {
     COND_CODE_1(DT_NODE_HAS_PROP(n, prop),                                                         \
                 (DT_FOREACH_PROP_ELEM_SEP(n, prop, PROP_BIT_AT_IDX, (|))), (0))
 
+#define PROP_LAYER_BIT_AT_IDX(n, prop, idx) ZMK_KEYMAP_LAYER_BIT(DT_PROP_BY_IDX(n, prop, idx))
+
+#define NODE_PROP_LAYER_BITMASK(n, prop)                                                           \
+    COND_CODE_1(DT_NODE_HAS_PROP(n, prop),                                                         \
+                (DT_FOREACH_PROP_ELEM_SEP(n, prop, PROP_LAYER_BIT_AT_IDX, (|))), (0))
+
 #define GET_KEY_POSITION_MASK_PORTION(idx, n) ((NODE_PROP_BITMASK(n, key_positions) >> idx) & 0xFF)
 
 #define COMBO_INST(n, positions)                                                                   \
@@ -84,7 +90,7 @@ struct active_combo {
                         .key_position_len = DT_PROP_LEN(n, key_positions),                         \
                         .behavior = ZMK_KEYMAP_EXTRACT_BINDING(0, n),                              \
                         .slow_release = DT_PROP(n, slow_release),                                  \
-                        .layer_mask = NODE_PROP_BITMASK(n, layers),                                \
+                        .layer_mask = NODE_PROP_LAYER_BITMASK(n, layers),                          \
                     }, ),                                                                          \
                 ())
 
@@ -152,7 +158,7 @@ static bool combo_active_on_layer(const struct combo_cfg *combo, uint8_t layer)
         return true;
     }
 
-    return combo->layer_mask & BIT(layer);
+    return (combo->layer_mask & ZMK_KEYMAP_LAYER_BIT(layer)) != 0;
 }
 
 static bool is_quick_tap(const struct combo_cfg *combo, int64_t timestamp) {
@@ -32,14 +32,16 @@ static const uint8_t display_led_idx = DT_NODE_CHILD_IDX(DT_CHOSEN(zmk_display_l
 #endif
 
 static bool initialized = false;
+// Only touched from the display work queue
+static bool updates_running = false;
 
 static lv_obj_t *screen;
 
 __attribute__((weak)) lv_obj_t *zmk_display_status_screen() { return NULL; }
 
-void display_tick_cb(struct k_work *work) { lv_task_handler(); }
+void display_tick_cb(struct k_work *work);
 
-K_WORK_DEFINE(display_tick_work, display_tick_cb);
+K_WORK_DELAYABLE_DEFINE(display_tick_work, display_tick_cb);
 
 #if IS_ENABLED(CONFIG_ZMK_DISPLAY_WORK_QUEUE_DEDICATED)
 
@@ -57,27 +59,50 @@ struct k_work_q *zmk_display_work_q() {
 #endif
 }
 
-void display_timer_cb() { k_work_submit_to_queue(zmk_display_work_q(), &display_tick_work); }
+// LVGL pauses its refresh timer until something is invalidated and its animation timer while no
+// animation runs, so once the screen is up to date this only wakes up at the idle period (if any)
+// to pick up changes made by widgets that don't call zmk_display_request_update().
+void display_tick_cb(struct k_work *work) {
+    uint32_t next = lv_task_handler();
 
-K_TIMER_DEFINE(display_timer, display_timer_cb, NULL);
+    if (!updates_running) {
+        return;
+    }
+
+    if (next == LV_NO_TIMER_READY) {
+        if (CONFIG_ZMK_DISPLAY_IDLE_TICK_PERIOD_MS == 0) {
+            return;
+        }
+
+        next = CONFIG_ZMK_DISPLAY_IDLE_TICK_PERIOD_MS;
+    }
+
+    k_work_reschedule_for_queue(zmk_display_work_q(), &display_tick_work,
+                                K_MSEC(MAX(next, CONFIG_ZMK_DISPLAY_TICK_PERIOD_MS)));
+}
+
+void zmk_display_request_update(void) {
+#if !IS_ENABLED(CONFIG_ARCH_POSIX)
+    if (updates_running) {
+        k_work_reschedule_for_queue(zmk_display_work_q(), &display_tick_work, K_NO_WAIT);
+    }
+#endif // !IS_ENABLED(CONFIG_ARCH_POSIX)
+}
 
 void unblank_display_cb(struct k_work *work) {
 #if DT_HAS_CHOSEN(zmk_display_led)
     led_on(display_led, display_led_idx);
 #endif
     display_blanking_off(display);
-#if !IS_ENABLED(CONFIG_ARCH_POSIX)
-    k_timer_start(&display_timer, K_MSEC(CONFIG_ZMK_DISPLAY_TICK_PERIOD_MS),
-                  K_MSEC(CONFIG_ZMK_DISPLAY_TICK_PERIOD_MS));
-#endif // !IS_ENABLED(CONFIG_ARCH_POSIX)
+    updates_running = true;
+    zmk_display_request_update();
 }
 
 #if IS_ENABLED(CONFIG_ZMK_DISPLAY_BLANK_ON_IDLE)
 
 void blank_display_cb(struct k_work *work) {
-#if !IS_ENABLED(CONFIG_ARCH_POSIX)
-    k_timer_stop(&display_timer);
-#endif // !IS_ENABLED(CONFIG_ARCH_POSIX)
+    updates_running = false;
+    k_work_cancel_delayable(&display_tick_work);
     display_blanking_on(display);
 #if DT_HAS_CHOSEN(zmk_display_led)
     led_off(display_led, display_led_idx);
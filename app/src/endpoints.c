@@ -9,6 +9,10 @@
 
 #include <stdio.h>
 
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+#include <zephyr/bluetooth/conn.h>
+#endif
+
 #include <zmk/ble.h>
 #include <zmk/endpoints.h>
 #include <zmk/hid.h>
@@ -19,6 +23,7 @@
 #include <zmk/events/ble_active_profile_changed.h>
 #include <zmk/events/usb_conn_state_changed.h>
 #include <zmk/events/endpoint_changed.h>
+#include <zmk/telemetry.h>
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
@@ -189,6 +194,8 @@ static int send_consumer_report(void) {
 int zmk_endpoints_send_report(uint16_t usage_page) {
 
     LOG_DBG("usage page 0x%02X", usage_page);
+    zmk_telemetry_record_hid_report();
+
     switch (usage_page) {
     case HID_USAGE_KEY:
         return send_keyboard_report();
@@ -203,6 +210,8 @@ int zmk_endpoints_send_report(uint16_t usage_page) {
 
 #if IS_ENABLED(CONFIG_ZMK_POINTING)
 int zmk_endpoints_send_mouse_report() {
+    zmk_telemetry_record_hid_report();
+
     switch (current_instance.transport) {
     case ZMK_TRANSPORT_USB: {
 #if IS_ENABLED(CONFIG_ZMK_USB)
@@ -235,6 +244,37 @@ int zmk_endpoints_send_mouse_report() {
     LOG_ERR("Unhandled endpoint transport %d", current_instance.transport);
     return -ENOTSUP;
 }
+
+uint32_t zmk_endpoints_mouse_report_interval_us(void) {
+    switch (current_instance.transport) {
+    case ZMK_TRANSPORT_USB:
+#if IS_ENABLED(CONFIG_ZMK_USB)
+        return CONFIG_USB_HID_POLL_INTERVAL_MS * USEC_PER_MSEC;
+#else
+        return 0;
+#endif /* IS_ENABLED(CONFIG_ZMK_USB) */
+
+    case ZMK_TRANSPORT_BLE: {
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+        struct bt_conn *conn = zmk_ble_active_profile_conn();
+        if (conn == NULL) {
+            return 0;
+        }
+
+        struct bt_conn_info info;
+        int err = bt_conn_get_info(conn, &info);
+        bt_conn_unref(conn);
+
+        // Connection intervals are in units of 1.25 ms
+        return err < 0 ? 0 : info.le.interval * 1250U;
+#else
+        return 0;
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE) */
+    }
+    }
+
+    return 0;
+}
 #endif // IS_ENABLED(CONFIG_ZMK_POINTING)
 
 #if IS_ENABLED(CONFIG_SETTINGS)
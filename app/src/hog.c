@@ -18,6 +18,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/endpoints_types.h>
 #include <zmk/hog.h>
 #include <zmk/hid.h>
+#include <zmk/telemetry.h>
 #if IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
 #include <zmk/pointing/resolution_multipliers.h>
 #endif // IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
@@ -351,6 +352,8 @@ int zmk_hog_send_keyboard_report(struct zmk_hid_keyboard_report_body *report) {
         }
     }
 
+    zmk_telemetry_record_queue_depth(ZMK_TELEMETRY_QUEUE_HOG,
+                                     k_msgq_num_used_get(&zmk_hog_keyboard_msgq));
     k_work_submit_to_queue(&hog_work_q, &hog_keyboard_work);
 
     return 0;
@@ -403,6 +406,8 @@ int zmk_hog_send_consumer_report(struct zmk_hid_consumer_report_body *report) {
         }
     }
 
+    zmk_telemetry_record_queue_depth(ZMK_TELEMETRY_QUEUE_HOG,
+                                     k_msgq_num_used_get(&zmk_hog_consumer_msgq));
     k_work_submit_to_queue(&hog_work_q, &hog_consumer_work);
 
     return 0;
@@ -456,6 +461,8 @@ int zmk_hog_send_mouse_report(struct zmk_hid_mouse_report_body *report) {
         }
     }
 
+    zmk_telemetry_record_queue_depth(ZMK_TELEMETRY_QUEUE_HOG,
+                                     k_msgq_num_used_get(&zmk_hog_mouse_msgq));
     k_work_submit_to_queue(&hog_work_q, &hog_mouse_work);
 
     return 0;
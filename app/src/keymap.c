@@ -5,7 +5,10 @@
  */
 
 #include <drivers/behavior.h>
+#include <zephyr/kernel.h>
 #include <zephyr/sys/util.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/crc.h>
 #include <zephyr/settings/settings.h>
 #include <zephyr/logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
@@ -64,32 +67,317 @@ static zmk_keymap_layer_id_t _zmk_keymap_layer_default = 0;
 // When a behavior handles a key position "down" event, we record the layer state
 // here so that even if that layer is deactivated before the "up", event, we
 // still send the release event to the behavior in that layer also.
-static uint32_t zmk_keymap_active_behavior_layer[ZMK_KEYMAP_LEN];
+static zmk_keymap_layers_state_t zmk_keymap_active_behavior_layer[ZMK_KEYMAP_LEN];
+
+// For each position, the index of the highest layer that can handle it with the current layer
+// state, skipping over inactive layers and transparent bindings. Entries are filled lazily and
+// tagged with the generation they were found in. Changes to the layer state, the layer order, or
+// the bindings bump the generation after they're made, so older entries are rejected on read no
+// matter which thread made the change.
+static atomic_t position_start_layers[ZMK_KEYMAP_LEN];
+static atomic_t position_start_layers_generation = ATOMIC_INIT(0);
+
+// Each entry packs a valid bit, the low bits of the generation, and the layer index
+#define START_LAYER_ENTRY_VALID BIT(31)
+#define START_LAYER_ENTRY_GENERATION_MASK BIT_MASK(23)
+#define START_LAYER_ENTRY(_generation, _idx)                                                       \
+    (START_LAYER_ENTRY_VALID | (((_generation) & START_LAYER_ENTRY_GENERATION_MASK) << 8) | (_idx))
+
+static inline void invalidate_position_start_layers(void) {
+    atomic_inc(&position_start_layers_generation);
+}
+
+BUILD_ASSERT(ZMK_KEYMAP_LAYERS_LEN <= ZMK_KEYMAP_LAYERS_STATE_BITS,
+             "Too many keymap layers for the layer state, enable CONFIG_ZMK_KEYMAP_LAYER_STATE_64");
+
+#define KEYMAP_VAR(_name)                                                                          \
+    static const struct zmk_behavior_binding _name[ZMK_KEYMAP_LAYERS_LEN][ZMK_KEYMAP_LEN] = {      \
+        ZMK_KEYMAP_LAYERS_FOREACH_SEP(TRANSFORMED_LAYER, (, ))};
+
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_SETTINGS_STORAGE)
+
+// The stock keymap stays in flash, and only the bindings that differ from it are kept in RAM, in a
+// pool of slots. A slot is never changed while a published copy of the keymap data refers to it,
+// edits go to a free slot instead and the old one is reused once no copy refers to it anymore.
+KEYMAP_VAR(zmk_stock_keymap)
+
+struct keymap_binding_override {
+    zmk_keymap_layer_id_t layer;
+    uint16_t position;
+    struct zmk_behavior_binding binding;
+};
+
+#define KEYMAP_MAX_BINDING_OVERRIDES                                                               \
+    MIN(CONFIG_ZMK_KEYMAP_MAX_BINDING_OVERRIDES, ZMK_KEYMAP_LEN * ZMK_KEYMAP_LAYERS_LEN)
+
+BUILD_ASSERT(KEYMAP_MAX_BINDING_OVERRIDES <= UINT16_MAX, "Too many binding overrides");
+
+static struct keymap_binding_override binding_override_slots[KEYMAP_MAX_BINDING_OVERRIDES];
+
+// Only used by the writer holding the keymap write lock. Used slots are those the live copy refers
+// to plus the ones taken by the current write, which can still be changed in place.
+static uint8_t binding_override_slots_used[DIV_ROUND_UP(KEYMAP_MAX_BINDING_OVERRIDES, 8)];
+static uint8_t binding_override_slots_fresh[DIV_ROUND_UP(KEYMAP_MAX_BINDING_OVERRIDES, 8)];
+
+#else
 
+KEYMAP_VAR(zmk_keymap)
+
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_SETTINGS_STORAGE)
+
+// The parts of the keymap that can be changed at runtime are kept in two copies. Readers use the
+// live copy, while a writer updates the other one and then publishes it with a single pointer
+// swap. A writer waits for any readers still holding a copy before reusing it, so the key
+// processing path never blocks and never sees a half-applied change.
+struct keymap_data {
+    atomic_t readers;
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
+    uint8_t layer_orders[ZMK_KEYMAP_LAYERS_LEN];
+    // The inverse of layer_orders
+    uint8_t layer_indexes[ZMK_KEYMAP_LAYERS_LEN];
+#endif
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_SETTINGS_STORAGE)
+    size_t overrides_len;
+    // Indexes into binding_override_slots, sorted by layer and then key position
+    uint16_t overrides[KEYMAP_MAX_BINDING_OVERRIDES];
+#endif
+};
 
-static uint8_t keymap_layer_orders[ZMK_KEYMAP_LAYERS_LEN];
+static struct keymap_data keymap_data_bufs[2];
+static atomic_ptr_t keymap_data_live = ATOMIC_PTR_INIT(&keymap_data_bufs[0]);
+static K_MUTEX_DEFINE(keymap_write_lock);
 
-#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
+// Given when the last reader lets go of a copy that isn't live anymore, which a writer may be
+// waiting on before reusing it
+static K_SEM_DEFINE(keymap_readers_done, 0, 1);
+
+static inline const struct keymap_data *live_keymap_data(void) {
+    return atomic_ptr_get(&keymap_data_live);
+}
+
+static inline void keymap_read_end(const struct keymap_data *data) {
+    if (atomic_dec(&((struct keymap_data *)data)->readers) == 1 &&
+        data != atomic_ptr_get(&keymap_data_live)) {
+        k_sem_give(&keymap_readers_done);
+    }
+}
+
+// Pointers into the keymap data remain valid until the matching keymap_read_end
+static inline const struct keymap_data *keymap_read_begin(void) {
+    while (true) {
+        struct keymap_data *data = atomic_ptr_get(&keymap_data_live);
 
-#define KEYMAP_VAR(_name, _opts, no_init)                                                          \
-    static _opts struct zmk_behavior_binding _name[ZMK_KEYMAP_LAYERS_LEN][ZMK_KEYMAP_LEN] = {      \
-        COND_CODE_0(no_init, (ZMK_KEYMAP_LAYERS_FOREACH_SEP(TRANSFORMED_LAYER, (, ))), (0))};
+        atomic_inc(&data->readers);
+        if (data == atomic_ptr_get(&keymap_data_live)) {
+            return data;
+        }
+
+        // Swapped before we could claim it, so try again with the new copy
+        keymap_read_end(data);
+    }
+}
+
+static inline struct keymap_data *keymap_write_begin(void) {
+    k_mutex_lock(&keymap_write_lock, K_FOREVER);
+
+    struct keymap_data *live = atomic_ptr_get(&keymap_data_live);
+    struct keymap_data *shadow =
+        live == &keymap_data_bufs[0] ? &keymap_data_bufs[1] : &keymap_data_bufs[0];
+
+    // Readers letting go after the reset give the semaphore, so none of them can be missed
+    k_sem_reset(&keymap_readers_done);
+    while (atomic_get(&shadow->readers) > 0) {
+        k_sem_take(&keymap_readers_done, K_FOREVER);
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
+    memcpy(shadow->layer_orders, live->layer_orders, sizeof(shadow->layer_orders));
+    memcpy(shadow->layer_indexes, live->layer_indexes, sizeof(shadow->layer_indexes));
+#endif
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_SETTINGS_STORAGE)
+    shadow->overrides_len = live->overrides_len;
+    memcpy(shadow->overrides, live->overrides, live->overrides_len * sizeof(live->overrides[0]));
+
+    // Slots only the previous copy referred to are free again now that it has no readers left
+    memset(binding_override_slots_used, 0, sizeof(binding_override_slots_used));
+    memset(binding_override_slots_fresh, 0, sizeof(binding_override_slots_fresh));
+    for (size_t i = 0; i < live->overrides_len; i++) {
+        WRITE_BIT(binding_override_slots_used[live->overrides[i] / 8], live->overrides[i] % 8, 1);
+    }
+#endif
 
-KEYMAP_VAR(zmk_keymap, COND_CODE_1(IS_ENABLED(CONFIG_ZMK_KEYMAP_SETTINGS_STORAGE), (), (const)),
-           IS_ENABLED(CONFIG_ZMK_STUDIO))
+    return shadow;
+}
+
+static inline void keymap_write_commit(struct keymap_data *data) {
+    atomic_ptr_set(&keymap_data_live, data);
+    invalidate_position_start_layers();
+
+    k_mutex_unlock(&keymap_write_lock);
+}
+
+static inline void keymap_write_abort(struct keymap_data *data) {
+    k_mutex_unlock(&keymap_write_lock);
+}
 
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_SETTINGS_STORAGE)
 
-KEYMAP_VAR(zmk_stock_keymap, const, 0)
+#define BINDING_OVERRIDE_KEY(_layer, _position) (((uint32_t)(_layer) << 16) | (_position))
+
+static inline struct keymap_binding_override *override_at(const struct keymap_data *data,
+                                                          size_t idx) {
+    return &binding_override_slots[data->overrides[idx]];
+}
+
+// Find the index of the first override at or after the given key
+static size_t find_binding_override(const struct keymap_data *data, uint32_t key) {
+    size_t lo = 0, hi = data->overrides_len;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const struct keymap_binding_override *o = override_at(data, mid);
+
+        if (BINDING_OVERRIDE_KEY(o->layer, o->position) < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static const struct keymap_binding_override *
+get_binding_override(const struct keymap_data *data, zmk_keymap_layer_id_t layer,
+                     uint32_t position) {
+    size_t idx = find_binding_override(data, BINDING_OVERRIDE_KEY(layer, position));
+
+    if (idx < data->overrides_len && override_at(data, idx)->layer == layer &&
+        override_at(data, idx)->position == position) {
+        return override_at(data, idx);
+    }
+
+    return NULL;
+}
+
+// Takes a slot the live copy doesn't refer to, returns -ENOMEM if there are none left
+static int alloc_binding_override_slot(void) {
+    for (int i = 0; i < KEYMAP_MAX_BINDING_OVERRIDES; i++) {
+        if (!(binding_override_slots_used[i / 8] & BIT(i % 8))) {
+            WRITE_BIT(binding_override_slots_used[i / 8], i % 8, 1);
+            WRITE_BIT(binding_override_slots_fresh[i / 8], i % 8, 1);
+            return i;
+        }
+    }
+
+    return -ENOMEM;
+}
+
+// Slots taken by the current write can be reused right away, others wait for the next write
+static void release_binding_override_slot(uint16_t slot) {
+    if (binding_override_slots_fresh[slot / 8] & BIT(slot % 8)) {
+        WRITE_BIT(binding_override_slots_used[slot / 8], slot % 8, 0);
+        WRITE_BIT(binding_override_slots_fresh[slot / 8], slot % 8, 0);
+    }
+}
+
+static bool bindings_equal(const struct zmk_behavior_binding *a,
+                           const struct zmk_behavior_binding *b) {
+    if (a->param1 != b->param1 || a->param2 != b->param2) {
+        return false;
+    }
+
+    if (a->behavior_dev == b->behavior_dev) {
+        return true;
+    }
+
+    return a->behavior_dev && b->behavior_dev && strcmp(a->behavior_dev, b->behavior_dev) == 0;
+}
+
+static int set_binding_override(struct keymap_data *data, zmk_keymap_layer_id_t layer,
+                                uint32_t position, const struct zmk_behavior_binding *binding) {
+    size_t idx = find_binding_override(data, BINDING_OVERRIDE_KEY(layer, position));
+    bool exists = idx < data->overrides_len && override_at(data, idx)->layer == layer &&
+                  override_at(data, idx)->position == position;
+
+    // Going back to the stock binding frees up the slot
+    if (bindings_equal(binding, &zmk_stock_keymap[layer][position])) {
+        if (exists) {
+            release_binding_override_slot(data->overrides[idx]);
+            memmove(&data->overrides[idx], &data->overrides[idx + 1],
+                    (data->overrides_len - idx - 1) * sizeof(data->overrides[0]));
+            data->overrides_len--;
+        }
+
+        return 0;
+    }
+
+    uint16_t slot = exists ? data->overrides[idx] : 0;
+
+    // Slots the live copy refers to may be in use by readers, so changes go to a new one
+    if (!exists || !(binding_override_slots_fresh[slot / 8] & BIT(slot % 8))) {
+        int new_slot = alloc_binding_override_slot();
+        if (new_slot < 0) {
+            LOG_ERR("No room to override the binding for layer %d at position %d", layer,
+                    position);
+            return new_slot;
+        }
+
+        slot = new_slot;
+    }
+
+    if (!exists) {
+        memmove(&data->overrides[idx + 1], &data->overrides[idx],
+                (data->overrides_len - idx) * sizeof(data->overrides[0]));
+        data->overrides_len++;
+    }
+
+    data->overrides[idx] = slot;
+    binding_override_slots[slot] = (struct keymap_binding_override){
+        .layer = layer,
+        .position = position,
+        .binding = *binding,
+    };
+
+    return 0;
+}
+
+static void clear_layer_binding_overrides(struct keymap_data *data, zmk_keymap_layer_id_t layer) {
+    size_t start = find_binding_override(data, BINDING_OVERRIDE_KEY(layer, 0));
+    size_t end = find_binding_override(data, BINDING_OVERRIDE_KEY(layer + 1, 0));
+
+    for (size_t i = start; i < end; i++) {
+        release_binding_override_slot(data->overrides[i]);
+    }
+
+    memmove(&data->overrides[start], &data->overrides[end],
+            (data->overrides_len - end) * sizeof(data->overrides[0]));
+    data->overrides_len -= end - start;
+}
+
+// Looks the binding up in the given copy, which has to be claimed by the caller's read section or
+// be the copy it's writing. The returned binding stays valid for as long as that claim.
+static const struct zmk_behavior_binding *keymap_binding(const struct keymap_data *data,
+                                                         zmk_keymap_layer_id_t layer,
+                                                         uint32_t position) {
+    const struct keymap_binding_override *override = get_binding_override(data, layer, position);
+
+    return override ? &override->binding : &zmk_stock_keymap[layer][position];
+}
 
 static char zmk_keymap_layer_names[ZMK_KEYMAP_LAYERS_LEN][CONFIG_ZMK_KEYMAP_LAYER_NAME_MAX_LEN] = {
     ZMK_KEYMAP_LAYERS_FOREACH_SEP(LAYER_NAME, (, ))};
 
-static uint32_t changed_layer_names = 0;
+static zmk_keymap_layers_state_t changed_layer_names = 0;
 
 #else
 
+static const struct zmk_behavior_binding *keymap_binding(const struct keymap_data *data,
+                                                         zmk_keymap_layer_id_t layer,
+                                                         uint32_t position) {
+    return &zmk_keymap[layer][position];
+}
+
 static const char *zmk_keymap_layer_names[ZMK_KEYMAP_LAYERS_LEN] = {
     ZMK_KEYMAP_LAYERS_FOREACH_SEP(LAYER_NAME, (, ))};
 
@@ -110,23 +398,57 @@ static struct zmk_behavior_binding
 
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
 
-uint8_t map_layer_id_to_index(zmk_keymap_layer_id_t layer_id) {
+static uint8_t map_layer_id_to_index(const struct keymap_data *data,
+                                     zmk_keymap_layer_id_t layer_id) {
+    if (layer_id >= ZMK_KEYMAP_LAYERS_LEN) {
+        return ZMK_KEYMAP_LAYER_ID_INVAL;
+    }
+
+    return data->layer_indexes[layer_id];
+}
+
+// Must be called after any change to the layer order of a copy being written
+static void update_layer_indexes(struct keymap_data *data) {
+    memset(data->layer_indexes, ZMK_KEYMAP_LAYER_ID_INVAL, sizeof(data->layer_indexes));
+
     for (uint8_t i = 0; i < ZMK_KEYMAP_LAYERS_LEN; i++) {
-        if (keymap_layer_orders[i] == layer_id) {
-            return i;
+        zmk_keymap_layer_id_t layer_id = data->layer_orders[i];
+        if (layer_id < ZMK_KEYMAP_LAYERS_LEN) {
+            data->layer_indexes[layer_id] = i;
         }
     }
+}
+
+// The active layers keyed by index rather than ID. Only the few active layers are visited.
+static zmk_keymap_layers_state_t active_layer_indexes(const struct keymap_data *data) {
+    zmk_keymap_layers_state_t ids = _zmk_keymap_layer_state;
+    zmk_keymap_layers_state_t indexes = 0;
 
-    return ZMK_KEYMAP_LAYER_ID_INVAL;
+    for (int id = zmk_keymap_layers_state_fls(ids); id >= 0;
+         id = zmk_keymap_layers_state_fls(ids)) {
+        ids &= ~ZMK_KEYMAP_LAYER_BIT(id);
+
+        uint8_t idx = data->layer_indexes[id];
+        if (idx < ZMK_KEYMAP_LAYERS_LEN) {
+            indexes |= ZMK_KEYMAP_LAYER_BIT(idx);
+        }
+    }
+
+    return indexes;
 }
 
-#define LAYER_INDEX_TO_ID(_layer) keymap_layer_orders[_layer]
-#define LAYER_ID_TO_INDEX(_layer) map_layer_id_to_index(_layer)
+// The layer order is read from the given copy, claimed by the caller like for bindings
+#define LAYER_INDEX_TO_ID(_data, _layer) (_data)->layer_orders[_layer]
+#define LAYER_ID_TO_INDEX(_data, _layer) map_layer_id_to_index(_data, _layer)
 
 #else
 
-#define LAYER_INDEX_TO_ID(_layer) _layer
-#define LAYER_ID_TO_INDEX(_layer) _layer
+#define LAYER_INDEX_TO_ID(_data, _layer) (_layer)
+#define LAYER_ID_TO_INDEX(_data, _layer) (_layer)
+
+static zmk_keymap_layers_state_t active_layer_indexes(const struct keymap_data *data) {
+    return _zmk_keymap_layer_state;
+}
 
 #endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
 
@@ -142,9 +464,15 @@ static inline int set_layer_state(zmk_keymap_layer_id_t layer_id, bool state) {
     }
 
     zmk_keymap_layers_state_t old_state = _zmk_keymap_layer_state;
-    WRITE_BIT(_zmk_keymap_layer_state, layer_id, state);
+    if (state) {
+        _zmk_keymap_layer_state |= ZMK_KEYMAP_LAYER_BIT(layer_id);
+    } else {
+        _zmk_keymap_layer_state &= ~ZMK_KEYMAP_LAYER_BIT(layer_id);
+    }
     // Don't send state changes unless there was an actual change
     if (old_state != _zmk_keymap_layer_state) {
+        invalidate_position_start_layers();
+
         LOG_DBG("layer_changed: layer %d state %d", layer_id, state);
         ret = raise_layer_state_changed(layer_id, state);
         if (ret < 0) {
@@ -158,7 +486,11 @@ static inline int set_layer_state(zmk_keymap_layer_id_t layer_id, bool state) {
 zmk_keymap_layer_id_t zmk_keymap_layer_index_to_id(zmk_keymap_layer_index_t layer_index) {
     ASSERT_LAYER_VAL(layer_index, UINT8_MAX);
 
-    return LAYER_INDEX_TO_ID(layer_index);
+    const struct keymap_data *data = keymap_read_begin();
+    zmk_keymap_layer_id_t layer_id = LAYER_INDEX_TO_ID(data, layer_index);
+    keymap_read_end(data);
+
+    return layer_id;
 }
 
 zmk_keymap_layer_id_t zmk_keymap_layer_default(void) { return _zmk_keymap_layer_default; }
@@ -169,7 +501,7 @@ bool zmk_keymap_layer_active_with_state(zmk_keymap_layer_id_t layer,
                                         zmk_keymap_layers_state_t state_to_test) {
     // The default layer is assumed to be ALWAYS ACTIVE so we include an || here to ensure nobody
     // breaks up that assumption by accident
-    return (state_to_test & (BIT(layer))) == (BIT(layer)) || layer == _zmk_keymap_layer_default;
+    return (state_to_test & ZMK_KEYMAP_LAYER_BIT(layer)) != 0 || layer == _zmk_keymap_layer_default;
 };
 
 bool zmk_keymap_layer_active(zmk_keymap_layer_id_t layer) {
@@ -177,19 +509,13 @@ bool zmk_keymap_layer_active(zmk_keymap_layer_id_t layer) {
 };
 
 zmk_keymap_layer_index_t zmk_keymap_highest_layer_active(void) {
-    for (int layer_idx = ZMK_KEYMAP_LAYERS_LEN - 1;
-         layer_idx >= LAYER_ID_TO_INDEX(_zmk_keymap_layer_default); layer_idx--) {
-        zmk_keymap_layer_id_t layer_id = LAYER_INDEX_TO_ID(layer_idx);
-
-        if (layer_id == ZMK_KEYMAP_LAYER_ID_INVAL) {
-            continue;
-        }
-        if (zmk_keymap_layer_active(layer_id)) {
-            return LAYER_ID_TO_INDEX(layer_id);
-        }
-    }
+    // The default layer is always active, and nothing below it in the order is considered
+    const struct keymap_data *data = keymap_read_begin();
+    int highest_idx = zmk_keymap_layers_state_fls(active_layer_indexes(data));
+    int default_idx = LAYER_ID_TO_INDEX(data, _zmk_keymap_layer_default);
+    keymap_read_end(data);
 
-    return LAYER_ID_TO_INDEX(zmk_keymap_layer_default());
+    return MAX(highest_idx, default_idx);
 }
 
 int zmk_keymap_layer_activate(zmk_keymap_layer_id_t layer) { return set_layer_state(layer, true); };
@@ -207,8 +533,15 @@ int zmk_keymap_layer_toggle(zmk_keymap_layer_id_t layer) {
 };
 
 int zmk_keymap_layer_to(zmk_keymap_layer_id_t layer) {
-    for (int i = ZMK_KEYMAP_LAYERS_LEN - 1; i >= 0; i--) {
+    zmk_keymap_layers_state_t default_bit = ZMK_KEYMAP_LAYER_BIT(_zmk_keymap_layer_default);
+    zmk_keymap_layers_state_t remaining = _zmk_keymap_layer_state & ~default_bit;
+
+    // Deactivate from the highest layer ID down, re-reading the state each time in case a
+    // listener for the change (de)activates other layers below this one
+    for (int i = zmk_keymap_layers_state_fls(remaining); i >= 0;
+         i = zmk_keymap_layers_state_fls(remaining)) {
         zmk_keymap_layer_deactivate(i);
+        remaining = _zmk_keymap_layer_state & ~default_bit & (ZMK_KEYMAP_LAYER_BIT(i) - 1);
     }
 
     zmk_keymap_layer_activate(layer);
@@ -222,8 +555,9 @@ const char *zmk_keymap_layer_name(zmk_keymap_layer_id_t layer_id) {
     return zmk_keymap_layer_names[layer_id];
 }
 
-const struct zmk_behavior_binding *
-zmk_keymap_get_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint8_t binding_idx) {
+static const struct zmk_behavior_binding *layer_binding_at_idx(const struct keymap_data *data,
+                                                               zmk_keymap_layer_id_t layer_id,
+                                                               uint16_t binding_idx) {
     if (binding_idx >= ZMK_KEYMAP_LEN) {
         return NULL;
     }
@@ -249,7 +583,57 @@ zmk_keymap_get_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint8_t bind
         return NULL;
     }
 
-    return &zmk_keymap[layer_id][mapped_idx];
+    return keymap_binding(data, layer_id, mapped_idx);
+}
+
+// Deprecated, only kept for out of tree callers. Nothing here claims the copy it returns from.
+const struct zmk_behavior_binding *
+zmk_keymap_get_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint16_t binding_idx) {
+    return layer_binding_at_idx(live_keymap_data(), layer_id, binding_idx);
+}
+
+int zmk_keymap_copy_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint16_t binding_idx,
+                                         struct zmk_behavior_binding *binding) {
+    const struct keymap_data *data = keymap_read_begin();
+    const struct zmk_behavior_binding *found = layer_binding_at_idx(data, layer_id, binding_idx);
+
+    if (found) {
+        *binding = *found;
+    }
+
+    keymap_read_end(data);
+
+    return found ? 0 : -EINVAL;
+}
+
+int zmk_keymap_foreach_layer_binding(zmk_keymap_layer_id_t layer_id,
+                                     zmk_keymap_layer_binding_cb_t cb, void *user_data) {
+    ASSERT_LAYER_VAL(layer_id, -EINVAL)
+
+    const uint32_t *pos_map;
+    int len = zmk_physical_layouts_get_selected_to_stock_position_map(&pos_map);
+    if (len < 0) {
+        LOG_WRN("Failed to get the position map, can't visit the layer bindings (%d)", len);
+        return len;
+    }
+
+    const struct keymap_data *data = keymap_read_begin();
+    int ret = 0;
+
+    for (uint16_t binding_idx = 0; binding_idx < MIN(len, ZMK_KEYMAP_LEN); binding_idx++) {
+        uint32_t mapped_idx = pos_map[binding_idx];
+        const struct zmk_behavior_binding *binding =
+            mapped_idx < ZMK_KEYMAP_LEN ? keymap_binding(data, layer_id, mapped_idx) : NULL;
+
+        ret = cb(binding_idx, binding, user_data);
+        if (ret != 0) {
+            break;
+        }
+    }
+
+    keymap_read_end(data);
+
+    return ret;
 }
 
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_SETTINGS_STORAGE)
@@ -258,52 +642,100 @@ zmk_keymap_get_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint8_t bind
 
 static uint8_t zmk_keymap_layer_pending_changes[ZMK_KEYMAP_LAYERS_LEN][PENDING_ARRAY_SIZE];
 
-int zmk_keymap_set_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint8_t binding_idx,
-                                        struct zmk_behavior_binding binding) {
-    if (binding_idx >= ZMK_KEYMAP_LEN) {
+// Maps the binding index of an update to the key position it's stored at
+static int binding_update_position(const struct zmk_keymap_binding_update *update,
+                                   const uint32_t *pos_map, int pos_map_len) {
+    if (update->binding_idx >= ZMK_KEYMAP_LEN || update->layer >= ZMK_KEYMAP_LAYERS_LEN) {
         return -EINVAL;
     }
 
-    ASSERT_LAYER_VAL(layer_id, -EINVAL)
+    if (update->binding_idx >= pos_map_len) {
+        LOG_WRN("Unable to set binding at index %d which isn't mapped", update->binding_idx);
+        return -EINVAL;
+    }
+
+    uint32_t storage_binding_idx = pos_map[update->binding_idx];
+
+    if (storage_binding_idx >= ZMK_KEYMAP_LEN) {
+        LOG_WRN("Can't set layer binding at unmapped/invalid index %d", update->binding_idx);
+        return -EINVAL;
+    }
+
+    return storage_binding_idx;
+}
 
+int zmk_keymap_set_bindings(const struct zmk_keymap_binding_update *updates, size_t len) {
     const uint32_t *pos_map;
-    int ret = zmk_physical_layouts_get_selected_to_stock_position_map(&pos_map);
-    if (ret < 0) {
-        LOG_WRN("Failed to get the mapping to determine where to set the binding (%d)", ret);
-        return ret;
+    int pos_map_len = zmk_physical_layouts_get_selected_to_stock_position_map(&pos_map);
+    if (pos_map_len < 0) {
+        LOG_WRN("Failed to get the mapping to determine where to set the bindings (%d)",
+                pos_map_len);
+        return pos_map_len;
     }
 
-    if (binding_idx >= ret) {
-        LOG_WRN("Unable to set binding at index %d which isn't mapped", binding_idx);
-        return -EINVAL;
+    for (size_t i = 0; i < len; i++) {
+        int ret = binding_update_position(&updates[i], pos_map, pos_map_len);
+        if (ret < 0) {
+            return ret;
+        }
     }
 
-    uint32_t storage_binding_idx = pos_map[binding_idx];
+    struct keymap_data *data = keymap_write_begin();
+    bool changed = false;
 
-    if (storage_binding_idx >= ZMK_KEYMAP_LEN) {
-        LOG_WRN("Can't set layer binding at unmapped/invalid index %d", binding_idx);
-        return -EINVAL;
+    // Only marked as pending once the whole batch is applied
+    uint8_t pending[ZMK_KEYMAP_LAYERS_LEN][PENDING_ARRAY_SIZE];
+    memcpy(pending, zmk_keymap_layer_pending_changes, sizeof(pending));
+
+    for (size_t i = 0; i < len; i++) {
+        const struct zmk_keymap_binding_update *update = &updates[i];
+        int position = binding_update_position(update, pos_map, pos_map_len);
+
+        if (bindings_equal(keymap_binding(data, update->layer, position), &update->binding)) {
+            LOG_DBG("Not setting, no change to layer %d at index %d (%d)", update->layer,
+                    update->binding_idx, position);
+            continue;
+        }
+
+        int ret = set_binding_override(data, update->layer, position, &update->binding);
+        if (ret < 0) {
+            keymap_write_abort(data);
+            return ret;
+        }
+
+        WRITE_BIT(pending[update->layer][position / 8], position % 8, 1);
+        changed = true;
     }
 
-    if (memcmp(&zmk_keymap[layer_id][storage_binding_idx], &binding, sizeof(binding)) == 0) {
-        LOG_DBG("Not setting, no change to layer %d at index %d (%d)", layer_id, binding_idx,
-                storage_binding_idx);
+    if (!changed) {
+        keymap_write_abort(data);
         return 0;
     }
 
-    uint8_t *pending = zmk_keymap_layer_pending_changes[layer_id];
+    memcpy(zmk_keymap_layer_pending_changes, pending, sizeof(pending));
+    keymap_write_commit(data);
 
-    WRITE_BIT(pending[storage_binding_idx / 8], storage_binding_idx % 8, 1);
+    return 0;
+}
 
-    // TODO: Need a mutex to protect access to the keymap data?
-    memcpy(&zmk_keymap[layer_id][storage_binding_idx], &binding, sizeof(binding));
+int zmk_keymap_set_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint16_t binding_idx,
+                                        struct zmk_behavior_binding binding) {
+    struct zmk_keymap_binding_update update = {
+        .layer = layer_id,
+        .binding_idx = binding_idx,
+        .binding = binding,
+    };
 
-    return 0;
+    return zmk_keymap_set_bindings(&update, 1);
 }
 
 #else
 
-int zmk_keymap_set_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint8_t binding_idx,
+int zmk_keymap_set_bindings(const struct zmk_keymap_binding_update *updates, size_t len) {
+    return -ENOTSUP;
+}
+
+int zmk_keymap_set_layer_binding_at_idx(zmk_keymap_layer_id_t layer_id, uint16_t binding_idx,
                                         struct zmk_behavior_binding binding) {
     return -ENOTSUP;
 }
@@ -323,68 +755,90 @@ int zmk_keymap_move_layer(zmk_keymap_layer_index_t start_idx, zmk_keymap_layer_i
 
     if (start_idx == dest_idx) {
         return 0;
-    } else if (dest_idx > start_idx) {
-        uint8_t val = keymap_layer_orders[start_idx];
+    }
+
+    struct keymap_data *data = keymap_write_begin();
+    uint8_t *orders = data->layer_orders;
+
+    if (dest_idx > start_idx) {
+        uint8_t val = orders[start_idx];
 
         for (int i = start_idx; i < dest_idx; i++) {
-            keymap_layer_orders[i] = keymap_layer_orders[i + 1];
+            orders[i] = orders[i + 1];
         }
 
-        keymap_layer_orders[dest_idx] = val;
+        orders[dest_idx] = val;
     } else {
-        uint8_t val = keymap_layer_orders[start_idx];
+        uint8_t val = orders[start_idx];
 
         for (int i = start_idx; i > dest_idx; i--) {
-            keymap_layer_orders[i] = keymap_layer_orders[i - 1];
+            orders[i] = orders[i - 1];
         }
 
-        keymap_layer_orders[dest_idx] = val;
+        orders[dest_idx] = val;
     }
 
+    update_layer_indexes(data);
+    keymap_write_commit(data);
+
     return 0;
 }
 
 int zmk_keymap_add_layer(void) {
-    uint32_t seen_layer_ids = 0;
-    LOG_HEXDUMP_DBG(keymap_layer_orders, ZMK_KEYMAP_LAYERS_LEN, "Order");
+    zmk_keymap_layers_state_t seen_layer_ids = 0;
+    struct keymap_data *data = keymap_write_begin();
+    uint8_t *orders = data->layer_orders;
+
+    LOG_HEXDUMP_DBG(orders, ZMK_KEYMAP_LAYERS_LEN, "Order");
 
     for (int index = 0; index < ZMK_KEYMAP_LAYERS_LEN; index++) {
-        zmk_keymap_layer_id_t id = LAYER_INDEX_TO_ID(index);
+        zmk_keymap_layer_id_t id = orders[index];
 
         if (id != ZMK_KEYMAP_LAYER_ID_INVAL) {
-            WRITE_BIT(seen_layer_ids, id, 1);
+            seen_layer_ids |= ZMK_KEYMAP_LAYER_BIT(id);
             continue;
         }
 
         for (int candidate_id = 0; candidate_id < ZMK_KEYMAP_LAYERS_LEN; candidate_id++) {
-            if (!(seen_layer_ids & BIT(candidate_id))) {
-                keymap_layer_orders[index] = candidate_id;
+            if (!(seen_layer_ids & ZMK_KEYMAP_LAYER_BIT(candidate_id))) {
+                orders[index] = candidate_id;
+                update_layer_indexes(data);
+                keymap_write_commit(data);
                 return index;
             }
         }
     }
 
+    keymap_write_abort(data);
+
     return -ENOSPC;
 }
 
 int zmk_keymap_remove_layer(zmk_keymap_layer_index_t index) {
     ASSERT_LAYER_VAL(index, -EINVAL);
 
-    if (keymap_layer_orders[index] == ZMK_KEYMAP_LAYER_ID_INVAL) {
+    struct keymap_data *data = keymap_write_begin();
+    uint8_t *orders = data->layer_orders;
+
+    if (orders[index] == ZMK_KEYMAP_LAYER_ID_INVAL) {
+        keymap_write_abort(data);
         return -EINVAL;
     }
 
-    LOG_DBG("Removing layer index %d which is ID %d", index, keymap_layer_orders[index]);
-    LOG_HEXDUMP_DBG(keymap_layer_orders, ZMK_KEYMAP_LAYERS_LEN, "Order");
+    LOG_DBG("Removing layer index %d which is ID %d", index, orders[index]);
+    LOG_HEXDUMP_DBG(orders, ZMK_KEYMAP_LAYERS_LEN, "Order");
 
     while (index < ZMK_KEYMAP_LAYERS_LEN - 1) {
-        keymap_layer_orders[index] = keymap_layer_orders[index + 1];
+        orders[index] = orders[index + 1];
         index++;
     }
 
-    keymap_layer_orders[ZMK_KEYMAP_LAYERS_LEN - 1] = ZMK_KEYMAP_LAYER_ID_INVAL;
+    orders[ZMK_KEYMAP_LAYERS_LEN - 1] = ZMK_KEYMAP_LAYER_ID_INVAL;
+    update_layer_indexes(data);
 
-    LOG_HEXDUMP_DBG(keymap_layer_orders, ZMK_KEYMAP_LAYERS_LEN, "Order");
+    LOG_HEXDUMP_DBG(orders, ZMK_KEYMAP_LAYERS_LEN, "Order");
+
+    keymap_write_commit(data);
 
     return 0;
 }
@@ -393,11 +847,16 @@ int zmk_keymap_restore_layer(zmk_keymap_layer_id_t id, zmk_keymap_layer_index_t
     ASSERT_LAYER_VAL(at_index, -EINVAL);
     ASSERT_LAYER_VAL(id, -ENODEV);
 
+    struct keymap_data *data = keymap_write_begin();
+    uint8_t *orders = data->layer_orders;
+
     for (zmk_keymap_layer_index_t index = ZMK_KEYMAP_LAYERS_LEN - 1; index > at_index; index--) {
-        keymap_layer_orders[index] = keymap_layer_orders[index - 1];
+        orders[index] = orders[index - 1];
     }
 
-    keymap_layer_orders[at_index] = id;
+    orders[at_index] = id;
+    update_layer_indexes(data);
+    keymap_write_commit(data);
 
     return 0;
 }
@@ -416,7 +875,7 @@ int zmk_keymap_set_layer_name(zmk_keymap_layer_id_t id, const char *name, size_t
         zmk_keymap_layer_names[id][size] = 0;
     }
 
-    WRITE_BIT(changed_layer_names, id, 1);
+    changed_layer_names |= ZMK_KEYMAP_LAYER_BIT(id);
 
     return 0;
 }
@@ -461,61 +920,242 @@ int zmk_keymap_check_unsaved_changes(void) {
                 return 1;
             }
         }
+    }
 
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
-        if (settings_layer_orders[l] != keymap_layer_orders[l]) {
-            return 1;
-        }
-#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
+    const struct keymap_data *data = keymap_read_begin();
+    bool orders_changed =
+        memcmp(settings_layer_orders, data->layer_orders, sizeof(settings_layer_orders)) != 0;
+    keymap_read_end(data);
+
+    if (orders_changed) {
+        return 1;
     }
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
 
     return 0;
 }
 
 #define LAYER_ORDER_SETTINGS_KEY "keymap/layer_order"
 #define LAYER_NAME_SETTINGS_KEY "keymap/l_n/%d"
+// Legacy format with one setting per binding, only read to migrate to the layer blobs
 #define LAYER_BINDING_SETTINGS_KEY "keymap/l/%d/%d"
+#define LAYER_BLOB_SETTINGS_KEY "keymap/lb/%d"
+
+// A layer blob holds the bindings of a layer that differ from the stock keymap: the header, then
+// for each of them the key position, the behavior local ID, param1 and param2 as unsigned LEB128
+// varints, then a CRC32 of everything before it. Positions missing from the blob use the stock
+// binding, so changes to the stock keymap still show through. Version 1 blobs held every binding of
+// the layer in key position order, without the positions, and are still loaded.
+#define LAYER_BLOB_VERSION_DENSE 1
+#define LAYER_BLOB_VERSION 2
+
+struct keymap_layer_blob_header {
+    uint8_t version;
+    // Number of bindings in the blob
+    uint16_t bindings_len;
+} __packed;
 
-static int save_bindings(void) {
-    for (int l = 0; l < ZMK_KEYMAP_LAYERS_LEN; l++) {
-        uint8_t *pending = zmk_keymap_layer_pending_changes[l];
+// Worst case varint sizes for the key position, the local ID and the two params
+#define LAYER_BLOB_BINDING_MAX_LEN (3 + 3 + 5 + 5)
+#define LAYER_BLOB_MAX_LEN                                                                         \
+    (sizeof(struct keymap_layer_blob_header) + (ZMK_KEYMAP_LEN * LAYER_BLOB_BINDING_MAX_LEN) +     \
+     sizeof(uint32_t))
+
+// Loading only happens from settings handlers, which the settings subsystem already serializes.
+// Saves come from Studio as well as the legacy migration on the system work queue, so they get a
+// buffer and lock of their own. Sharing one lock with the loader would invert the lock order with
+// the settings subsystem, which saves lock after the buffer and loads before it.
+static uint8_t layer_blob_load_buf[LAYER_BLOB_MAX_LEN];
+static uint8_t layer_blob_save_buf[LAYER_BLOB_MAX_LEN];
+static K_MUTEX_DEFINE(layer_blob_save_lock);
+
+// Layers that were loaded from a blob, whose legacy per-binding settings must be ignored, and
+// layers that still had legacy settings which need to be migrated to a blob.
+static zmk_keymap_layers_state_t blob_loaded_layers = 0;
+static zmk_keymap_layers_state_t legacy_binding_layers = 0;
+
+// Layers whose stored bindings didn't fit in the overrides. They're never saved, so the stored
+// bindings survive until the limit is raised.
+static zmk_keymap_layers_state_t overflowed_layers = 0;
+
+static size_t layer_blob_put_varint(uint8_t *buf, uint32_t val) {
+    size_t len = 0;
+
+    do {
+        uint8_t byte = val & 0x7F;
+        val >>= 7;
+        buf[len++] = byte | (val ? 0x80 : 0);
+    } while (val);
+
+    return len;
+}
 
-        for (int kp = 0; kp < ZMK_KEYMAP_LEN; kp++) {
-            if (pending[kp / 8] & BIT(kp % 8)) {
+static int layer_blob_get_varint(const uint8_t *buf, size_t len, size_t *offset, uint32_t *val) {
+    *val = 0;
 
-                const struct zmk_behavior_binding *binding = &zmk_keymap[l][kp];
-                LOG_DBG("Pending save for layer %d at key position %d: %s with %d, %d", l, kp,
-                        binding->behavior_dev, binding->param1, binding->param2);
-
-                struct zmk_behavior_binding_setting binding_setting = {
-                    .behavior_local_id = zmk_behavior_get_local_id(binding->behavior_dev),
-                    .param1 = binding->param1,
-                    .param2 = binding->param2,
-                };
-
-                // We can skip any trailing zero params, regardless of the behavior
-                // and if those params are meaningful.
-                size_t len = sizeof(binding_setting);
-                if (binding_setting.param2 == 0) {
-                    len -= 4;
-
-                    if (binding_setting.param1 == 0) {
-                        len -= 4;
-                    }
-                }
+    for (int shift = 0; shift < 32 && *offset < len; shift += 7) {
+        uint8_t byte = buf[(*offset)++];
+        *val |= (uint32_t)(byte & 0x7F) << shift;
 
-                char setting_name[20];
-                sprintf(setting_name, LAYER_BINDING_SETTINGS_KEY, l, kp);
+        if (!(byte & 0x80)) {
+            return 0;
+        }
+    }
 
-                int ret = settings_save_one(setting_name, &binding_setting, len);
-                if (ret < 0) {
-                    LOG_ERR("Failed to save keymap binding at %d on layer %d (%d)", l, kp, ret);
-                    return ret;
-                }
+    return -EINVAL;
+}
 
-                WRITE_BIT(pending[kp / 8], kp % 8, 0);
-            }
+static size_t encode_layer_blob(zmk_keymap_layer_id_t layer, uint8_t *buf) {
+    size_t len = sizeof(struct keymap_layer_blob_header);
+
+    const struct keymap_data *data = keymap_read_begin();
+
+    size_t start = find_binding_override(data, BINDING_OVERRIDE_KEY(layer, 0));
+    size_t end = find_binding_override(data, BINDING_OVERRIDE_KEY(layer + 1, 0));
+
+    for (size_t i = start; i < end; i++) {
+        const struct keymap_binding_override *override = override_at(data, i);
+        const struct zmk_behavior_binding *binding = &override->binding;
+
+        len += layer_blob_put_varint(&buf[len], override->position);
+        len += layer_blob_put_varint(&buf[len], zmk_behavior_get_local_id(binding->behavior_dev));
+        len += layer_blob_put_varint(&buf[len], binding->param1);
+        len += layer_blob_put_varint(&buf[len], binding->param2);
+    }
+
+    keymap_read_end(data);
+
+    struct keymap_layer_blob_header header = {
+        .version = LAYER_BLOB_VERSION,
+        .bindings_len = end - start,
+    };
+    memcpy(buf, &header, sizeof(header));
+
+    uint32_t crc = crc32_ieee(buf, len);
+    memcpy(&buf[len], &crc, sizeof(crc));
+
+    return len + sizeof(crc);
+}
+
+static int decode_layer_blob(struct keymap_data *data, zmk_keymap_layer_id_t layer,
+                             const uint8_t *buf, size_t len) {
+    struct keymap_layer_blob_header header;
+    uint32_t crc;
+
+    if (len < sizeof(header) + sizeof(crc)) {
+        LOG_WRN("Layer %d blob is too short (%d)", layer, len);
+        return -EINVAL;
+    }
+
+    len -= sizeof(crc);
+    memcpy(&crc, &buf[len], sizeof(crc));
+    if (crc != crc32_ieee(buf, len)) {
+        LOG_ERR("Layer %d blob failed the CRC check, ignoring it", layer);
+        return -EINVAL;
+    }
+
+    memcpy(&header, buf, sizeof(header));
+    if (header.version != LAYER_BLOB_VERSION && header.version != LAYER_BLOB_VERSION_DENSE) {
+        LOG_WRN("Unsupported layer %d blob version %d", layer, header.version);
+        return -ENOTSUP;
+    }
+
+    bool dense = header.version == LAYER_BLOB_VERSION_DENSE;
+
+    clear_layer_binding_overrides(data, layer);
+
+    size_t offset = sizeof(header);
+    for (int i = 0; i < header.bindings_len; i++) {
+        uint32_t position = i, local_id, param1, param2;
+
+        if ((!dense && layer_blob_get_varint(buf, len, &offset, &position) < 0) ||
+            layer_blob_get_varint(buf, len, &offset, &local_id) < 0 ||
+            layer_blob_get_varint(buf, len, &offset, &param1) < 0 ||
+            layer_blob_get_varint(buf, len, &offset, &param2) < 0) {
+            LOG_ERR("Truncated layer %d blob at binding %d", layer, i);
+            return -EINVAL;
+        }
+
+        if (position >= ZMK_KEYMAP_LEN) {
+            LOG_WRN("Layer %d blob has a binding for invalid key position %d", layer, position);
+            continue;
+        }
+
+        const char *name = zmk_behavior_find_behavior_name_from_local_id(local_id);
+        if (!name) {
+            LOG_WRN("Loaded device %d from settings but no device found by that local ID",
+                    local_id);
+        }
+
+        struct zmk_behavior_binding binding = {
+#if IS_ENABLED(CONFIG_ZMK_BEHAVIOR_LOCAL_IDS_IN_BINDINGS)
+            .local_id = local_id,
+#endif
+            .behavior_dev = name,
+            .param1 = param1,
+            .param2 = param2,
+        };
+
+        // Bindings matching the stock keymap are skipped here, so dense blobs end up sparse
+        int ret = set_binding_override(data, layer, position, &binding);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+static int save_layer_bindings(zmk_keymap_layer_id_t layer) {
+    if (overflowed_layers & ZMK_KEYMAP_LAYER_BIT(layer)) {
+        LOG_ERR("Not saving layer %d, its stored bindings didn't fit in RAM", layer);
+        return -ENOMEM;
+    }
+
+    char setting_name[14];
+    sprintf(setting_name, LAYER_BLOB_SETTINGS_KEY, layer);
+
+    k_mutex_lock(&layer_blob_save_lock, K_FOREVER);
+
+    size_t len = encode_layer_blob(layer, layer_blob_save_buf);
+
+    LOG_DBG("Saving %d byte blob for layer %d", len, layer);
+
+    int ret = settings_save_one(setting_name, layer_blob_save_buf, len);
+
+    k_mutex_unlock(&layer_blob_save_lock);
+
+    if (ret < 0) {
+        LOG_ERR("Failed to save keymap bindings for layer %d (%d)", layer, ret);
+        return ret;
+    }
+
+    return 0;
+}
+
+static bool layer_has_pending_changes(zmk_keymap_layer_id_t layer) {
+    for (int i = 0; i < PENDING_ARRAY_SIZE; i++) {
+        if (zmk_keymap_layer_pending_changes[layer][i]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int save_bindings(void) {
+    for (int l = 0; l < ZMK_KEYMAP_LAYERS_LEN; l++) {
+        if (!layer_has_pending_changes(l)) {
+            continue;
         }
+
+        int ret = save_layer_bindings(l);
+        if (ret < 0) {
+            return ret;
+        }
+
+        memset(zmk_keymap_layer_pending_changes[l], 0, PENDING_ARRAY_SIZE);
     }
 
     return 0;
@@ -523,20 +1163,25 @@ static int save_bindings(void) {
 
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
 static int save_layer_orders(void) {
-    int ret = settings_save_one(LAYER_ORDER_SETTINGS_KEY, keymap_layer_orders,
-                                ARRAY_SIZE(keymap_layer_orders));
+    uint8_t orders[ZMK_KEYMAP_LAYERS_LEN];
+
+    const struct keymap_data *data = keymap_read_begin();
+    memcpy(orders, data->layer_orders, sizeof(orders));
+    keymap_read_end(data);
+
+    int ret = settings_save_one(LAYER_ORDER_SETTINGS_KEY, orders, ZMK_KEYMAP_LAYERS_LEN);
     if (ret < 0) {
         return ret;
     }
 
-    memcpy(settings_layer_orders, keymap_layer_orders, ARRAY_SIZE(keymap_layer_orders));
+    memcpy(settings_layer_orders, orders, ZMK_KEYMAP_LAYERS_LEN);
     return 0;
 }
 #endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
 
 static int save_layer_names(void) {
     for (int id = 0; id < ZMK_KEYMAP_LAYERS_LEN; id++) {
-        if (changed_layer_names & BIT(id)) {
+        if (changed_layer_names & ZMK_KEYMAP_LAYER_BIT(id)) {
             char setting_name[14];
             sprintf(setting_name, LAYER_NAME_SETTINGS_KEY, id);
             int ret = settings_save_one(setting_name, zmk_keymap_layer_names[id],
@@ -570,31 +1215,36 @@ int zmk_keymap_save_changes(void) {
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
 
 #define KEYMAP_LAYER_ORDER_INIT(n)                                                                 \
-    keymap_layer_orders[i] = i;                                                                    \
+    data->layer_orders[i] = i;                                                                     \
     settings_layer_orders[i] = i;                                                                  \
     i++;
 
 static void load_stock_keymap_layer_ordering() {
+    struct keymap_data *data = keymap_write_begin();
     int i = 0;
     DT_INST_FOREACH_CHILD_STATUS_OKAY(0, KEYMAP_LAYER_ORDER_INIT)
     while (i < ZMK_KEYMAP_LAYERS_LEN) {
-        keymap_layer_orders[i] = ZMK_KEYMAP_LAYER_ID_INVAL;
+        data->layer_orders[i] = ZMK_KEYMAP_LAYER_ID_INVAL;
         i++;
     }
+
+    update_layer_indexes(data);
+    keymap_write_commit(data);
 }
 #endif
 
 static void reload_from_stock_keymap(void) {
-    for (int l = 0; l < ZMK_KEYMAP_LAYERS_LEN; l++) {
-        for (int k = 0; k < ZMK_KEYMAP_LEN; k++) {
-            zmk_keymap[l][k] = zmk_stock_keymap[l][k];
-        }
-    }
+    struct keymap_data *data = keymap_write_begin();
+
+    data->overrides_len = 0;
+
+    keymap_write_commit(data);
 }
 
 int zmk_keymap_discard_changes(void) {
     load_stock_keymap_layer_ordering();
     reload_from_stock_keymap();
+    blob_loaded_layers = 0;
 
     int ret = settings_load_subtree("keymap");
     if (ret >= 0) {
@@ -628,15 +1278,70 @@ static int keymap_track_changed_bindings(const char *key, size_t len, settings_r
             return -EINVAL;
         }
 
+        if (layer >= ZMK_KEYMAP_LAYERS_LEN || key_position >= ZMK_KEYMAP_LEN) {
+            return 0;
+        }
+
         WRITE_BIT((*state)[layer][key_position / 8], key_position % 8, 1);
     }
     return 0;
 }
 
+static int delete_legacy_bindings(void) {
+    uint8_t zmk_keymap_layer_changes[ZMK_KEYMAP_LAYERS_LEN][PENDING_ARRAY_SIZE] = {0};
+
+    int ret = settings_load_subtree_direct("keymap", keymap_track_changed_bindings,
+                                           &zmk_keymap_layer_changes);
+    if (ret < 0) {
+        return ret;
+    }
+
+    for (int l = 0; l < ZMK_KEYMAP_LAYERS_LEN; l++) {
+        uint8_t *changes = zmk_keymap_layer_changes[l];
+
+        for (int k = 0; k < ZMK_KEYMAP_LEN; k++) {
+            if (changes[k / 8] & BIT(k % 8)) {
+                char setting_name[20];
+                sprintf(setting_name, LAYER_BINDING_SETTINGS_KEY, l, k);
+                settings_delete(setting_name);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void migrate_legacy_bindings_work_cb(struct k_work *work) {
+    zmk_keymap_layers_state_t layers = legacy_binding_layers;
+
+    LOG_INF("Migrating keymap bindings to per-layer settings");
+
+    for (int l = 0; l < ZMK_KEYMAP_LAYERS_LEN; l++) {
+        if (!(layers & ZMK_KEYMAP_LAYER_BIT(l))) {
+            continue;
+        }
+
+        // Only delete the old settings once every affected layer is safely stored as a blob
+        if (save_layer_bindings(l) < 0) {
+            return;
+        }
+    }
+
+    int ret = delete_legacy_bindings();
+    if (ret < 0) {
+        LOG_WRN("Failed to delete the legacy keymap binding settings (%d)", ret);
+        return;
+    }
+
+    legacy_binding_layers &= ~layers;
+}
+
+static K_WORK_DEFINE(migrate_legacy_bindings_work, migrate_legacy_bindings_work_cb);
+
 int zmk_keymap_reset_settings(void) {
     settings_delete(LAYER_ORDER_SETTINGS_KEY);
 
-    uint8_t zmk_keymap_layer_changes[ZMK_KEYMAP_LAYERS_LEN][PENDING_ARRAY_SIZE];
+    uint8_t zmk_keymap_layer_changes[ZMK_KEYMAP_LAYERS_LEN][PENDING_ARRAY_SIZE] = {0};
 
     settings_load_subtree_direct("keymap", keymap_track_changed_bindings,
                                  &zmk_keymap_layer_changes);
@@ -646,11 +1351,18 @@ int zmk_keymap_reset_settings(void) {
         sprintf(layer_name_setting_name, LAYER_NAME_SETTINGS_KEY, l);
         settings_delete(layer_name_setting_name);
 
+        char layer_blob_setting_name[14];
+        sprintf(layer_blob_setting_name, LAYER_BLOB_SETTINGS_KEY, l);
+        settings_delete(layer_blob_setting_name);
+
         uint8_t *changes = zmk_keymap_layer_changes[l];
 
         for (int k = 0; k < ZMK_KEYMAP_LEN; k++) {
-            if (memcmp(&zmk_keymap[l][k], &zmk_stock_keymap[l][k],
-                       sizeof(struct zmk_behavior_binding_setting)) == 0) {
+            const struct keymap_data *data = keymap_read_begin();
+            bool overridden = get_binding_override(data, l, k) != NULL;
+            keymap_read_end(data);
+
+            if (!overridden) {
                 continue;
             }
 
@@ -666,6 +1378,9 @@ int zmk_keymap_reset_settings(void) {
     load_stock_keymap_layer_ordering();
 
     reload_from_stock_keymap();
+    blob_loaded_layers = 0;
+    legacy_binding_layers = 0;
+    overflowed_layers = 0;
 
     return 0;
 }
@@ -680,10 +1395,10 @@ int zmk_keymap_reset_settings(void) { return -ENOTSUP; }
 
 #endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_SETTINGS_STORAGE)
 
-int zmk_keymap_apply_position_state(uint8_t source, zmk_keymap_layer_id_t layer_id,
-                                    uint32_t position, bool pressed, int64_t timestamp) {
-    const struct zmk_behavior_binding *binding =
-        zmk_keymap_get_layer_binding_at_idx(layer_id, position);
+static int apply_position_state(const struct keymap_data *data, uint8_t source,
+                                zmk_keymap_layer_id_t layer_id, uint32_t position, bool pressed,
+                                int64_t timestamp) {
+    const struct zmk_behavior_binding *binding = layer_binding_at_idx(data, layer_id, position);
     struct zmk_behavior_binding_event event = {
         .layer = layer_id,
         .position = position,
@@ -699,24 +1414,93 @@ int zmk_keymap_apply_position_state(uint8_t source, zmk_keymap_layer_id_t layer_
     return zmk_behavior_invoke_binding(binding, event, pressed);
 }
 
-int zmk_keymap_position_state_changed(uint8_t source, uint32_t position, bool pressed,
-                                      int64_t timestamp) {
+#if DT_HAS_COMPAT_STATUS_OKAY(zmk_behavior_transparent)
+#define TRANSPARENT_BEHAVIOR_NAME DEVICE_DT_NAME(DT_INST(0, zmk_behavior_transparent))
+#endif
+
+// Bindings that always pass the event on to the next layer down, without side effects
+static bool binding_is_transparent(const struct zmk_behavior_binding *binding) {
+    if (!binding->behavior_dev || binding->behavior_dev[0] == '\0') {
+        return true;
+    }
+
+#if DT_HAS_COMPAT_STATUS_OKAY(zmk_behavior_transparent)
+    return binding->behavior_dev == TRANSPARENT_BEHAVIOR_NAME ||
+           strcmp(binding->behavior_dev, TRANSPARENT_BEHAVIOR_NAME) == 0;
+#else
+    return false;
+#endif
+}
+
+static int position_start_layer_index(const struct keymap_data *data, uint32_t position) {
+    // Read before anything the entry is computed from, so a change made meanwhile leaves it stale
+    atomic_val_t generation = atomic_get(&position_start_layers_generation);
+    atomic_val_t entry = atomic_get(&position_start_layers[position]);
+
+    if (entry == START_LAYER_ENTRY(generation, entry & 0xFF)) {
+        return entry & 0xFF;
+    }
+
+    int default_idx = LAYER_ID_TO_INDEX(data, _zmk_keymap_layer_default);
+    int start_idx = default_idx;
+
+    // Only the active layers above the default one are candidates
+    zmk_keymap_layers_state_t candidates = active_layer_indexes(data);
+    if (default_idx < ZMK_KEYMAP_LAYERS_STATE_BITS) {
+        zmk_keymap_layers_state_t default_bit = ZMK_KEYMAP_LAYER_BIT(default_idx);
+        candidates &= ~(default_bit | (default_bit - 1));
+    }
+
+    for (int layer_idx = zmk_keymap_layers_state_fls(candidates); layer_idx >= 0;
+         layer_idx = zmk_keymap_layers_state_fls(candidates)) {
+        candidates &= ~ZMK_KEYMAP_LAYER_BIT(layer_idx);
+
+        zmk_keymap_layer_id_t layer_id = LAYER_INDEX_TO_ID(data, layer_idx);
+        if (layer_id == ZMK_KEYMAP_LAYER_ID_INVAL) {
+            continue;
+        }
+
+        const struct zmk_behavior_binding *binding = layer_binding_at_idx(data, layer_id, position);
+        if (!binding || !binding_is_transparent(binding)) {
+            start_idx = layer_idx;
+            break;
+        }
+    }
+
+    // A copy replaced before the generation was read would be tagged as current, so only cache what
+    // was found in the live one
+    if (data == live_keymap_data()) {
+        atomic_set(&position_start_layers[position], START_LAYER_ENTRY(generation, start_idx));
+    }
+
+    return start_idx;
+}
+
+static int keymap_position_state_changed(const struct keymap_data *data, uint8_t source,
+                                         uint32_t position, bool pressed, int64_t timestamp) {
     if (pressed) {
         zmk_keymap_active_behavior_layer[position] = _zmk_keymap_layer_state;
     }
 
+    // Releases after a layer change have to be resolved against the layer state at the time of
+    // the press, which the cache doesn't track.
+    int start_idx = ZMK_KEYMAP_LAYERS_LEN - 1;
+    if (position < ZMK_KEYMAP_LEN &&
+        zmk_keymap_active_behavior_layer[position] == _zmk_keymap_layer_state) {
+        start_idx = position_start_layer_index(data, position);
+    }
+
     // We use int here to be sure we don't loop layer_idx back to UINT8_MAX
-    for (int layer_idx = ZMK_KEYMAP_LAYERS_LEN - 1;
-         layer_idx >= LAYER_ID_TO_INDEX(_zmk_keymap_layer_default); layer_idx--) {
-        zmk_keymap_layer_id_t layer_id = LAYER_INDEX_TO_ID(layer_idx);
+    for (int layer_idx = start_idx;
+         layer_idx >= LAYER_ID_TO_INDEX(data, _zmk_keymap_layer_default); layer_idx--) {
+        zmk_keymap_layer_id_t layer_id = LAYER_INDEX_TO_ID(data, layer_idx);
 
         if (layer_id == ZMK_KEYMAP_LAYER_ID_INVAL) {
             continue;
         }
         if (zmk_keymap_layer_active_with_state(layer_id,
                                                zmk_keymap_active_behavior_layer[position])) {
-            int ret =
-                zmk_keymap_apply_position_state(source, layer_id, position, pressed, timestamp);
+            int ret = apply_position_state(data, source, layer_id, position, pressed, timestamp);
             if (ret > 0) {
                 LOG_DBG("behavior processing to continue to next layer");
                 continue;
@@ -732,14 +1516,27 @@ int zmk_keymap_position_state_changed(uint8_t source, uint32_t position, bool pr
     return -ENOTSUP;
 }
 
+int zmk_keymap_position_state_changed(uint8_t source, uint32_t position, bool pressed,
+                                      int64_t timestamp) {
+    // Hold on to the keymap data while the bindings are being invoked, so edits from Studio are
+    // published for the next key event rather than under this one.
+    const struct keymap_data *data = keymap_read_begin();
+
+    int ret = keymap_position_state_changed(data, source, position, pressed, timestamp);
+
+    keymap_read_end(data);
+
+    return ret;
+}
+
 #if ZMK_KEYMAP_HAS_SENSORS
-int zmk_keymap_sensor_event(uint8_t sensor_index,
-                            const struct zmk_sensor_channel_data *channel_data,
-                            size_t channel_data_size, int64_t timestamp) {
+static int keymap_sensor_event(const struct keymap_data *data, uint8_t sensor_index,
+                               const struct zmk_sensor_channel_data *channel_data,
+                               size_t channel_data_size, int64_t timestamp) {
     bool opaque_response = false;
 
     for (int layer_idx = ZMK_KEYMAP_LAYERS_LEN - 1; layer_idx >= 0; layer_idx--) {
-        uint8_t layer_id = LAYER_INDEX_TO_ID(layer_idx);
+        uint8_t layer_id = LAYER_INDEX_TO_ID(data, layer_idx);
 
         if (layer_id >= ZMK_KEYMAP_LAYERS_LEN) {
             continue;
@@ -774,7 +1571,7 @@ int zmk_keymap_sensor_event(uint8_t sensor_index,
         }
 
         enum behavior_sensor_binding_process_mode mode =
-            (!opaque_response && layer_idx >= LAYER_ID_TO_INDEX(_zmk_keymap_layer_default) &&
+            (!opaque_response && layer_idx >= LAYER_ID_TO_INDEX(data, _zmk_keymap_layer_default) &&
              zmk_keymap_layer_active(layer_id))
                 ? BEHAVIOR_SENSOR_BINDING_PROCESS_MODE_TRIGGER
                 : BEHAVIOR_SENSOR_BINDING_PROCESS_MODE_DISCARD;
@@ -793,6 +1590,18 @@ int zmk_keymap_sensor_event(uint8_t sensor_index,
     return 0;
 }
 
+int zmk_keymap_sensor_event(uint8_t sensor_index,
+                            const struct zmk_sensor_channel_data *channel_data,
+                            size_t channel_data_size, int64_t timestamp) {
+    const struct keymap_data *data = keymap_read_begin();
+
+    int ret = keymap_sensor_event(data, sensor_index, channel_data, channel_data_size, timestamp);
+
+    keymap_read_end(data);
+
+    return ret;
+}
+
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
 
 int keymap_listener(const zmk_event_t *eh) {
@@ -810,11 +1619,18 @@ int keymap_listener(const zmk_event_t *eh) {
     }
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
 
+    if (as_zmk_physical_layout_selection_changed(eh) != NULL) {
+        // Bindings are looked up through the selected layout's position map
+        invalidate_position_start_layers();
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
     return -ENOTSUP;
 }
 
 ZMK_LISTENER(keymap, keymap_listener);
 ZMK_SUBSCRIPTION(keymap, zmk_position_state_changed);
+ZMK_SUBSCRIPTION(keymap, zmk_physical_layout_selection_changed);
 
 #if ZMK_KEYMAP_HAS_SENSORS
 ZMK_SUBSCRIPTION(keymap, zmk_sensor_event);
@@ -822,6 +1638,18 @@ ZMK_SUBSCRIPTION(keymap, zmk_sensor_event);
 
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_SETTINGS_STORAGE)
 
+// Everything loaded from settings goes into one write copy, which the commit handler publishes at
+// once. The settings subsystem calls the handlers from a single thread, so the copy stays with it.
+static struct keymap_data *settings_load_data;
+
+static struct keymap_data *settings_load_write_begin(void) {
+    if (!settings_load_data) {
+        settings_load_data = keymap_write_begin();
+    }
+
+    return settings_load_data;
+}
+
 static int keymap_handle_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg) {
     const char *next;
 
@@ -848,6 +1676,44 @@ static int keymap_handle_set(const char *name, size_t len, settings_read_cb read
         }
 
         zmk_keymap_layer_names[layer][ret] = 0;
+    } else if (settings_name_steq(name, "lb", &next) && next) {
+        char *endptr;
+        zmk_keymap_layer_id_t layer = strtoul(next, &endptr, 10);
+
+        if (*endptr != '\0') {
+            LOG_WRN("Invalid layer number: %s with endptr %s", next, endptr);
+            return -EINVAL;
+        }
+
+        if (layer >= ZMK_KEYMAP_LAYERS_LEN) {
+            LOG_WRN("Layer %d is larger than max of %d", layer, ZMK_KEYMAP_LAYERS_LEN);
+            return -EINVAL;
+        }
+
+        if (len > sizeof(layer_blob_load_buf)) {
+            LOG_ERR("Too large layer blob size (got %d max %d)", len, sizeof(layer_blob_load_buf));
+            return -EINVAL;
+        }
+
+        int ret = read_cb(cb_arg, layer_blob_load_buf, len);
+        if (ret <= 0) {
+            LOG_ERR("Failed to handle keymap layer blob from settings (err %d)", ret);
+            return ret;
+        }
+
+        struct keymap_data *data = settings_load_write_begin();
+
+        // A blob that fails to decode leaves its layer at the stock keymap
+        ret = decode_layer_blob(data, layer, layer_blob_load_buf, ret);
+        if (ret < 0) {
+            clear_layer_binding_overrides(data, layer);
+            if (ret == -ENOMEM) {
+                overflowed_layers |= ZMK_KEYMAP_LAYER_BIT(layer);
+            }
+            return ret;
+        }
+
+        blob_loaded_layers |= ZMK_KEYMAP_LAYER_BIT(layer);
     } else if (settings_name_steq(name, "l", &next) && next) {
         char *endptr;
         uint8_t layer = strtoul(next, &endptr, 10);
@@ -879,6 +1745,13 @@ static int keymap_handle_set(const char *name, size_t len, settings_read_cb read
             return -EINVAL;
         }
 
+        legacy_binding_layers |= ZMK_KEYMAP_LAYER_BIT(layer);
+
+        // The blob stands for the whole layer and supersedes any leftover legacy settings
+        if (blob_loaded_layers & ZMK_KEYMAP_LAYER_BIT(layer)) {
+            return 0;
+        }
+
         struct zmk_behavior_binding_setting binding_setting = {0};
         int err = read_cb(cb_arg, &binding_setting, len);
         if (err <= 0) {
@@ -894,7 +1767,7 @@ static int keymap_handle_set(const char *name, size_t len, settings_read_cb read
                     binding_setting.behavior_local_id);
         }
 
-        zmk_keymap[layer][key_position] = (struct zmk_behavior_binding){
+        struct zmk_behavior_binding binding = {
 #if IS_ENABLED(CONFIG_ZMK_BEHAVIOR_LOCAL_IDS_IN_BINDINGS)
             .local_id = binding_setting.behavior_local_id,
 #endif
@@ -902,6 +1775,14 @@ static int keymap_handle_set(const char *name, size_t len, settings_read_cb read
             .param1 = binding_setting.param1,
             .param2 = binding_setting.param2,
         };
+
+        err = set_binding_override(settings_load_write_begin(), layer, key_position, &binding);
+        if (err < 0) {
+            if (err == -ENOMEM) {
+                overflowed_layers |= ZMK_KEYMAP_LAYER_BIT(layer);
+            }
+            return err;
+        }
     }
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
     else if (settings_name_steq(name, "layer_order", &next) && !next) {
@@ -915,8 +1796,11 @@ static int keymap_handle_set(const char *name, size_t len, settings_read_cb read
         LOG_HEXDUMP_DBG(settings_layer_orders, ARRAY_SIZE(settings_layer_orders),
                         "Settings Layer Order");
 
-        memcpy(keymap_layer_orders, settings_layer_orders,
+        struct keymap_data *data = settings_load_write_begin();
+
+        memcpy(data->layer_orders, settings_layer_orders,
                MIN(len, ARRAY_SIZE(settings_layer_orders)));
+        update_layer_indexes(data);
     }
 #endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
 
@@ -924,24 +1808,38 @@ static int keymap_handle_set(const char *name, size_t len, settings_read_cb read
 };
 
 static int keymap_handle_commit(void) {
+    struct keymap_data *data = settings_load_data;
+    settings_load_data = NULL;
+
+    if (data) {
 #if IS_ENABLED(CONFIG_ZMK_BEHAVIOR_LOCAL_IDS_IN_BINDINGS)
-    for (int l = 0; l < ZMK_KEYMAP_LAYERS_LEN; l++) {
-        for (int p = 0; p < ZMK_KEYMAP_LEN; p++) {
-            struct zmk_behavior_binding *binding = &zmk_keymap[l][p];
+        for (size_t i = 0; i < data->overrides_len; i++) {
+            const struct keymap_binding_override *override = override_at(data, i);
+            struct zmk_behavior_binding binding = override->binding;
 
-            if (binding->local_id > 0 && !binding->behavior_dev) {
-                binding->behavior_dev =
-                    zmk_behavior_find_behavior_name_from_local_id(binding->local_id);
+            if (binding.local_id > 0 && !binding.behavior_dev) {
+                binding.behavior_dev =
+                    zmk_behavior_find_behavior_name_from_local_id(binding.local_id);
 
-                if (!binding->behavior_dev) {
+                if (!binding.behavior_dev) {
                     LOG_ERR("Failed to finding device for local ID %d after settings load",
-                            binding->local_id);
+                            binding.local_id);
+                    continue;
                 }
+
+                set_binding_override(data, override->layer, override->position, &binding);
             }
         }
-    }
 #endif
 
+        keymap_write_commit(data);
+    }
+
+    // The migration saves from the published copy
+    if (legacy_binding_layers) {
+        k_work_submit(&migrate_legacy_bindings_work);
+    }
+
     return 0;
 }
 
@@ -954,9 +1852,6 @@ int keymap_init(void) {
 #if IS_ENABLED(CONFIG_ZMK_KEYMAP_LAYER_REORDERING)
     load_stock_keymap_layer_ordering();
 #endif
-#if IS_ENABLED(CONFIG_ZMK_STUDIO)
-    reload_from_stock_keymap();
-#endif
 
     return 0;
 }
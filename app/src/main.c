@@ -33,9 +33,12 @@ int main(void) {
 #if IS_ENABLED(CONFIG_ARCH_POSIX)
     // Workaround for an SDL display issue:
     // https://github.com/zephyrproject-rtos/zephyr/issues/71410
+    // LVGL can't be woken up from the display work queue here, so wait for its next timer but
+    // keep polling often enough to pick up UI changes. A timer that is already due returns 0, so
+    // always sleep a little to let other threads run.
     while (1) {
-        lv_task_handler();
-        k_sleep(K_MSEC(10));
+        uint32_t next = lv_task_handler();
+        k_sleep(K_MSEC(CLAMP(next, 1, CONFIG_ZMK_DISPLAY_TICK_PERIOD_MS)));
     }
 #endif
 
@@ -22,6 +22,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/physical_layouts.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/position_state_changed.h>
+#include <zmk/telemetry.h>
 
 ZMK_EVENT_IMPL(zmk_physical_layout_selection_changed);
 
@@ -192,6 +193,11 @@ static void zmk_physical_layout_kscan_callback(const struct device *dev, uint32_
         .state = (pressed ? ZMK_KSCAN_EVENT_STATE_PRESSED : ZMK_KSCAN_EVENT_STATE_RELEASED)};
 
     k_msgq_put(&physical_layouts_kscan_msgq, &ev, K_NO_WAIT);
+
+    zmk_telemetry_record_kscan_event();
+    zmk_telemetry_record_queue_depth(ZMK_TELEMETRY_QUEUE_KSCAN,
+                                     k_msgq_num_used_get(&physical_layouts_kscan_msgq));
+
     k_work_submit(&msg_processor.work);
 }
 
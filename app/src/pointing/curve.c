@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2025 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/sys/util.h>
+
+#include <zmk/pointing/curve.h>
+
+static uint16_t permille_to_curve_value(int64_t permille_times_one) {
+    return CLAMP(permille_times_one / 1000, 0, UINT16_MAX);
+}
+
+void zmk_pointing_curve_build_exponent(uint16_t *curve, uint16_t from, uint16_t to,
+                                       uint8_t exponent, uint16_t one) {
+    int32_t range = to - from;
+
+    for (int i = 0; i < ZMK_POINTING_CURVE_POINTS; i++) {
+        // Extra fractional bits keep the rounding error of repeated multiplication out of the
+        // curve value
+        int64_t value = ((int64_t)range * one) << 16;
+        for (int e = 0; e < exponent && value != 0; e++) {
+            value = value * i / ZMK_POINTING_CURVE_SEGMENTS;
+        }
+
+        curve[i] = permille_to_curve_value((int64_t)from * one + (value >> 16));
+    }
+}
+
+void zmk_pointing_curve_build_from_points(uint16_t *curve, const uint16_t *points, uint8_t len,
+                                          uint16_t one) {
+    for (int i = 0; i < ZMK_POINTING_CURVE_POINTS; i++) {
+        uint32_t pos = i * (len - 1);
+        uint32_t idx = pos / ZMK_POINTING_CURVE_SEGMENTS;
+        uint32_t rem = pos % ZMK_POINTING_CURVE_SEGMENTS;
+
+        int32_t from = points[idx];
+        int32_t to = points[MIN(idx + 1, len - 1)];
+        int32_t permille = from + (to - from) * (int32_t)rem / ZMK_POINTING_CURVE_SEGMENTS;
+
+        curve[i] = permille_to_curve_value((int64_t)permille * one);
+    }
+}
@@ -26,6 +26,8 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #include <zmk/hid.h>
 #include <zmk/keymap.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/layer_state_changed.h>
 
 #define ONE_IF_DEV_OK(n)                                                                           \
     COND_CODE_1(DT_NODE_HAS_STATUS(DT_INST_PHANDLE(n, device), okay), (1 +), (0 +))
@@ -56,13 +58,13 @@ struct input_listener_config_entry {
 };
 
 struct input_listener_layer_override {
-    uint32_t layer_mask;
+    zmk_keymap_layers_state_t layer_mask;
     bool process_next;
     struct input_listener_config_entry config;
 };
 
 struct input_processor_remainder_data {
-    int16_t x, y, wheel, h_wheel;
+    int16_t rel[ZMK_INPUT_PROCESSOR_FRAME_AXIS_COUNT];
 };
 
 struct input_listener_processor_data {
@@ -93,69 +95,61 @@ struct input_listener_data {
     int16_t h_wheel_remainder;
 #endif // IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
 
+    // The frame-representable events received since the last sync, processed as a whole at sync
+    struct zmk_input_processor_frame frame;
+
+    // Bit per layer override whose layers are active, only recomputed when the layer state changes
+    atomic_t active_overrides;
+    atomic_t active_overrides_valid;
+
     struct input_listener_processor_data base_processor_data;
     struct input_listener_processor_data layer_override_data[];
 };
 
-static void handle_rel_code(struct input_listener_data *data, struct input_event *evt) {
-    switch (evt->code) {
-    case INPUT_REL_X:
-        data->mouse.data.mode = INPUT_LISTENER_XY_DATA_MODE_REL;
-        data->mouse.data.x.value += evt->value;
-        break;
-    case INPUT_REL_Y:
-        data->mouse.data.mode = INPUT_LISTENER_XY_DATA_MODE_REL;
-        data->mouse.data.y.value += evt->value;
-        break;
-    case INPUT_REL_WHEEL:
-        data->mouse.wheel_data.mode = INPUT_LISTENER_XY_DATA_MODE_REL;
-        data->mouse.wheel_data.y.value += evt->value;
-        break;
-    case INPUT_REL_HWHEEL:
-        data->mouse.wheel_data.mode = INPUT_LISTENER_XY_DATA_MODE_REL;
-        data->mouse.wheel_data.x.value += evt->value;
-        break;
-    default:
-        break;
-    }
-}
-
 static void handle_abs_code(const struct input_listener_config *config,
                             struct input_listener_data *data, struct input_event *evt) {}
 
-static void handle_key_code(const struct input_listener_config *config,
-                            struct input_listener_data *data, struct input_event *evt) {
-    int8_t btn;
-
-    switch (evt->code) {
-    case INPUT_BTN_0:
-    case INPUT_BTN_1:
-    case INPUT_BTN_2:
-    case INPUT_BTN_3:
-    case INPUT_BTN_4:
-        btn = evt->code - INPUT_BTN_0;
+static bool add_to_frame(struct zmk_input_processor_frame *frame, const struct input_event *evt) {
+    switch (evt->type) {
+    case INPUT_EV_REL: {
+        int axis = zmk_input_processor_frame_axis_for_code(evt->code);
+        if (axis < 0) {
+            return false;
+        }
+
+        frame->rel[axis] += evt->value;
+        frame->rel_present |= BIT(axis);
+        return true;
+    }
+    case INPUT_EV_KEY:
+        if (evt->code < INPUT_BTN_0 ||
+            evt->code >= INPUT_BTN_0 + ZMK_INPUT_PROCESSOR_FRAME_BUTTONS) {
+            return false;
+        }
+
         if (evt->value > 0) {
-            WRITE_BIT(data->mouse.button_set, btn, 1);
+            WRITE_BIT(frame->buttons_set, evt->code - INPUT_BTN_0, 1);
         } else {
-            WRITE_BIT(data->mouse.button_clear, btn, 1);
+            WRITE_BIT(frame->buttons_clear, evt->code - INPUT_BTN_0, 1);
         }
-        break;
+        return true;
     default:
-        break;
+        return false;
     }
 }
 
-static inline bool is_x_data(const struct input_event *evt) {
-    return evt->type == INPUT_EV_REL && evt->code == INPUT_REL_X;
+static inline bool frame_is_empty(const struct zmk_input_processor_frame *frame) {
+    return frame->rel_present == 0 && frame->buttons_set == 0 && frame->buttons_clear == 0;
 }
 
-static inline bool is_y_data(const struct input_event *evt) {
-    return evt->type == INPUT_EV_REL && evt->code == INPUT_REL_Y;
-}
+typedef int (*apply_config_func_t)(uint8_t listener_index,
+                                   const struct input_listener_config_entry *cfg,
+                                   struct input_listener_processor_data *processor_data,
+                                   void *input);
 
-static int apply_config(uint8_t listener_index, const struct input_listener_config_entry *cfg,
-                        struct input_listener_processor_data *processor_data,
-                        struct input_listener_data *data, struct input_event *evt) {
+static int apply_event_config(uint8_t listener_index, const struct input_listener_config_entry *cfg,
+                              struct input_listener_processor_data *processor_data, void *input) {
+    struct input_event *evt = input;
     size_t remainder_index = 0;
     for (size_t p = 0; p < cfg->processors_len; p++) {
         const struct zmk_input_processor_entry *proc_e = &cfg->processors[p];
@@ -165,22 +159,10 @@ static int apply_config(uint8_t listener_index, const struct input_listener_conf
         }
 
         int16_t *remainder = NULL;
-        if (remainders) {
-            if (evt->type == INPUT_EV_REL) {
-                switch (evt->code) {
-                case INPUT_REL_X:
-                    remainder = &remainders->x;
-                    break;
-                case INPUT_REL_Y:
-                    remainder = &remainders->y;
-                    break;
-                case INPUT_REL_WHEEL:
-                    remainder = &remainders->wheel;
-                    break;
-                case INPUT_REL_HWHEEL:
-                    remainder = &remainders->h_wheel;
-                    break;
-                }
+        if (remainders && evt->type == INPUT_EV_REL) {
+            int axis = zmk_input_processor_frame_axis_for_code(evt->code);
+            if (axis >= 0) {
+                remainder = &remainders->rel[axis];
             }
         }
 
@@ -201,36 +183,75 @@ static int apply_config(uint8_t listener_index, const struct input_listener_conf
     return ZMK_INPUT_PROC_CONTINUE;
 }
 
-static int filter_with_input_config(const struct input_listener_config *cfg,
-                                    struct input_listener_data *data, struct input_event *evt) {
-    if (!evt->dev) {
-        return -ENODEV;
+static int apply_frame_config(uint8_t listener_index, const struct input_listener_config_entry *cfg,
+                              struct input_listener_processor_data *processor_data, void *input) {
+    struct zmk_input_processor_frame *frame = input;
+    size_t remainder_index = 0;
+    for (size_t p = 0; p < cfg->processors_len; p++) {
+        const struct zmk_input_processor_entry *proc_e = &cfg->processors[p];
+        struct zmk_input_processor_frame_state state = {.input_device_index = listener_index};
+        if (proc_e->track_remainders) {
+            state.remainders = processor_data->remainders[remainder_index++].rel;
+        }
+
+        int ret = zmk_input_processor_handle_frame(proc_e->dev, frame, proc_e->param1,
+                                                   proc_e->param2, &state);
+        if (ret != ZMK_INPUT_PROC_CONTINUE) {
+            return ret;
+        }
+
+        if (frame_is_empty(frame)) {
+            // Every event of the frame was consumed, just like an event stopped by a processor
+            return ZMK_INPUT_PROC_STOP;
+        }
     }
 
+    return ZMK_INPUT_PROC_CONTINUE;
+}
+
+static void update_active_overrides(const struct input_listener_config *cfg,
+                                    struct input_listener_data *data) {
+    zmk_keymap_layers_state_t active_layers =
+        zmk_keymap_layer_state() | ZMK_KEYMAP_LAYER_BIT(zmk_keymap_layer_default());
+    atomic_val_t active_overrides = 0;
+
     for (size_t oi = 0; oi < cfg->layer_overrides_len; oi++) {
+        if ((cfg->layer_overrides[oi].layer_mask & active_layers) != 0) {
+            active_overrides |= BIT(oi);
+        }
+    }
+
+    atomic_set(&data->active_overrides, active_overrides);
+    atomic_set(&data->active_overrides_valid, true);
+}
+
+static int filter_with_input_config(const struct input_listener_config *cfg,
+                                    struct input_listener_data *data, apply_config_func_t apply,
+                                    void *input) {
+    if (!atomic_get(&data->active_overrides_valid)) {
+        update_active_overrides(cfg, data);
+    }
+
+    uint32_t active_overrides = (uint32_t)atomic_get(&data->active_overrides);
+
+    while (active_overrides != 0) {
+        size_t oi = __builtin_ctz(active_overrides);
         const struct input_listener_layer_override *override = &cfg->layer_overrides[oi];
         struct input_listener_processor_data *override_data = &data->layer_override_data[oi];
-        uint32_t mask = override->layer_mask;
-        uint8_t layer = 0;
-        while (mask != 0) {
-            if (mask & BIT(0) && zmk_keymap_layer_active(layer)) {
-                int ret =
-                    apply_config(cfg->listener_index, &override->config, override_data, data, evt);
-
-                if (ret < 0) {
-                    return ret;
-                }
-                if (!override->process_next) {
-                    return 0;
-                }
-            }
 
-            layer++;
-            mask = mask >> 1;
+        int ret = apply(cfg->listener_index, &override->config, override_data, input);
+
+        if (ret < 0) {
+            return ret;
+        }
+        if (!override->process_next) {
+            return 0;
         }
+
+        active_overrides &= active_overrides - 1;
     }
 
-    return apply_config(cfg->listener_index, &cfg->base, &data->base_processor_data, data, evt);
+    return apply(cfg->listener_index, &cfg->base, &data->base_processor_data, input);
 }
 
 static void clear_xy_data(struct input_listener_xy_data *data) {
@@ -239,11 +260,12 @@ static void clear_xy_data(struct input_listener_xy_data *data) {
 }
 
 #if IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
-static void apply_resolution_scaling(struct input_listener_data *data, struct input_event *evt) {
+static void apply_resolution_scaling(struct input_listener_data *data, uint16_t code,
+                                     int16_t *value) {
     int16_t *remainder;
     uint8_t div;
 
-    switch (evt->code) {
+    switch (code) {
     case INPUT_REL_WHEEL:
         remainder = &data->wheel_remainder;
         div = (16 - zmk_pointing_resolution_multipliers_get_current_profile().wheel);
@@ -256,76 +278,255 @@ static void apply_resolution_scaling(struct input_listener_data *data, struct in
         return;
     }
 
-    int16_t val = evt->value + *remainder;
+    int16_t val = *value + *remainder;
     int16_t scaled = val / (int16_t)div;
     *remainder = val - (scaled * (int16_t)div);
-    evt->value = val;
+    *value = val;
 }
 #endif // IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
 
-static void input_handler(const struct input_listener_config *config,
-                          struct input_listener_data *data, struct input_event *evt) {
-    // First, process to update the event data as needed.
-    int ret = filter_with_input_config(config, data, evt);
-
-    if (ret < 0) {
-        LOG_ERR("Error applying input processors: %d", ret);
-        return;
-    } else if (ret == ZMK_INPUT_PROC_STOP) {
-        return;
-    }
+static void handle_frame(struct input_listener_data *data,
+                         struct zmk_input_processor_frame *frame) {
+    for (int axis = 0; axis < ZMK_INPUT_PROCESSOR_FRAME_AXIS_COUNT; axis++) {
+        if (!(frame->rel_present & BIT(axis))) {
+            continue;
+        }
 
+        int16_t value = frame->rel[axis];
+
+        switch (axis) {
+        case ZMK_INPUT_PROCESSOR_FRAME_AXIS_X:
+            data->mouse.data.mode = INPUT_LISTENER_XY_DATA_MODE_REL;
+            data->mouse.data.x.value += value;
+            break;
+        case ZMK_INPUT_PROCESSOR_FRAME_AXIS_Y:
+            data->mouse.data.mode = INPUT_LISTENER_XY_DATA_MODE_REL;
+            data->mouse.data.y.value += value;
+            break;
+        case ZMK_INPUT_PROCESSOR_FRAME_AXIS_WHEEL:
 #if IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
-    apply_resolution_scaling(data, evt);
+            apply_resolution_scaling(data, INPUT_REL_WHEEL, &value);
 #endif // IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
-
-    switch (evt->type) {
-    case INPUT_EV_REL:
-        handle_rel_code(data, evt);
-        break;
-    case INPUT_EV_ABS:
-        handle_abs_code(config, data, evt);
-        break;
-    case INPUT_EV_KEY:
-        handle_key_code(config, data, evt);
-        break;
+            data->mouse.wheel_data.mode = INPUT_LISTENER_XY_DATA_MODE_REL;
+            data->mouse.wheel_data.y.value += value;
+            break;
+        case ZMK_INPUT_PROCESSOR_FRAME_AXIS_H_WHEEL:
+#if IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
+            apply_resolution_scaling(data, INPUT_REL_HWHEEL, &value);
+#endif // IS_ENABLED(CONFIG_ZMK_POINTING_SMOOTH_SCROLLING)
+            data->mouse.wheel_data.mode = INPUT_LISTENER_XY_DATA_MODE_REL;
+            data->mouse.wheel_data.x.value += value;
+            break;
+        }
     }
 
-    if (evt->sync) {
-        if (data->mouse.wheel_data.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
-            zmk_hid_mouse_scroll_set(data->mouse.wheel_data.x.value,
-                                     data->mouse.wheel_data.y.value);
-        }
+    data->mouse.button_set |= frame->buttons_set;
+    data->mouse.button_clear |= frame->buttons_clear;
+}
 
-        if (data->mouse.data.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
-            zmk_hid_mouse_movement_set(data->mouse.data.x.value, data->mouse.data.y.value);
+static void apply_buttons(struct input_listener_data *data) {
+    if (data->mouse.button_set != 0) {
+        for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
+            if ((data->mouse.button_set & BIT(i)) != 0) {
+                zmk_hid_mouse_button_press(i);
+            }
         }
+    }
 
-        if (data->mouse.button_set != 0) {
-            for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
-                if ((data->mouse.button_set & BIT(i)) != 0) {
-                    zmk_hid_mouse_button_press(i);
-                }
+    if (data->mouse.button_clear != 0) {
+        for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
+            if ((data->mouse.button_clear & BIT(i)) != 0) {
+                zmk_hid_mouse_button_release(i);
             }
         }
+    }
+}
+
+#if IS_ENABLED(CONFIG_ZMK_POINTING_REPORT_PACING)
+
+// Motion from all listeners is integrated here and sent at most once per host report slot.
+// Whatever doesn't fit into a single report is carried over to the next one.
+static struct {
+    int32_t x;
+    int32_t y;
+    int32_t wheel;
+    int32_t h_wheel;
+} pending_motion;
+
+// Far enough in the past that the first report is never delayed
+static int64_t last_mouse_report_ticks = INT64_MIN / 2;
+
+static K_MUTEX_DEFINE(mouse_report_lock);
+
+static void paced_report_work_cb(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(paced_report_work, paced_report_work_cb);
+
+static bool motion_is_pending(void) {
+    return pending_motion.x != 0 || pending_motion.y != 0 || pending_motion.wheel != 0 ||
+           pending_motion.h_wheel != 0;
+}
+
+static int16_t take_pending(int32_t *pending) {
+    int16_t value = CLAMP(*pending, INT16_MIN, INT16_MAX);
+    *pending -= value;
+    return value;
+}
+
+static int64_t report_interval_ticks(void) {
+    uint32_t interval_us = MAX(zmk_endpoints_mouse_report_interval_us(),
+                               CONFIG_ZMK_POINTING_REPORT_PACING_MIN_INTERVAL_MS * USEC_PER_MSEC);
+
+    return k_us_to_ticks_ceil64(interval_us);
+}
+
+// Must be called with mouse_report_lock held
+static void send_pending_report(void) {
+    // Only touch the axes with pending motion, just like unpaced reports do
+    if (pending_motion.h_wheel != 0 || pending_motion.wheel != 0) {
+        zmk_hid_mouse_scroll_set(take_pending(&pending_motion.h_wheel),
+                                 take_pending(&pending_motion.wheel));
+    }
+
+    if (pending_motion.x != 0 || pending_motion.y != 0) {
+        zmk_hid_mouse_movement_set(take_pending(&pending_motion.x),
+                                   take_pending(&pending_motion.y));
+    }
+
+    zmk_endpoints_send_mouse_report();
+    zmk_hid_mouse_scroll_set(0, 0);
+    zmk_hid_mouse_movement_set(0, 0);
+
+    last_mouse_report_ticks = k_uptime_ticks();
+
+    if (motion_is_pending()) {
+        k_work_schedule(&paced_report_work, K_TICKS(report_interval_ticks()));
+    }
+}
+
+static void paced_report_work_cb(struct k_work *work) {
+    k_mutex_lock(&mouse_report_lock, K_FOREVER);
+
+    if (motion_is_pending()) {
+        send_pending_report();
+    }
+
+    k_mutex_unlock(&mouse_report_lock);
+}
+
+static void send_mouse_report(struct input_listener_data *data) {
+    k_mutex_lock(&mouse_report_lock, K_FOREVER);
+
+    if (data->mouse.data.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
+        pending_motion.x += data->mouse.data.x.value;
+        pending_motion.y += data->mouse.data.y.value;
+    }
+
+    if (data->mouse.wheel_data.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
+        pending_motion.h_wheel += data->mouse.wheel_data.x.value;
+        pending_motion.wheel += data->mouse.wheel_data.y.value;
+    }
 
-        if (data->mouse.button_clear != 0) {
-            for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
-                if ((data->mouse.button_clear & BIT(i)) != 0) {
-                    zmk_hid_mouse_button_release(i);
-                }
+    if (data->mouse.button_set != 0 || data->mouse.button_clear != 0) {
+        // Button changes are never delayed, any pending motion goes out with them
+        apply_buttons(data);
+        send_pending_report();
+    } else if (motion_is_pending()) {
+        int64_t next_slot = last_mouse_report_ticks + report_interval_ticks();
+        int64_t now = k_uptime_ticks();
+
+        if (now >= next_slot) {
+            send_pending_report();
+        } else {
+            // Does nothing if a send is already scheduled for this slot
+            k_work_schedule(&paced_report_work, K_TICKS(next_slot - now));
+        }
+    }
+
+    k_mutex_unlock(&mouse_report_lock);
+}
+
+#else
+
+static void send_mouse_report(struct input_listener_data *data) {
+    if (data->mouse.wheel_data.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
+        zmk_hid_mouse_scroll_set(data->mouse.wheel_data.x.value, data->mouse.wheel_data.y.value);
+    }
+
+    if (data->mouse.data.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
+        zmk_hid_mouse_movement_set(data->mouse.data.x.value, data->mouse.data.y.value);
+    }
+
+    apply_buttons(data);
+
+    zmk_endpoints_send_mouse_report();
+    zmk_hid_mouse_scroll_set(0, 0);
+    zmk_hid_mouse_movement_set(0, 0);
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_POINTING_REPORT_PACING)
+
+static void input_handler(const struct input_listener_config *config,
+                          struct input_listener_data *data, struct input_event *evt) {
+    if (!evt->dev) {
+        LOG_ERR("Error applying input processors: %d", -ENODEV);
+        return;
+    }
+
+    // A sync that was stopped by a processor doesn't send a report, whatever was collected so far
+    // goes out with the next one.
+    bool stopped = false;
+
+    // Motion and buttons are collected into a frame and processed as a whole at sync, anything
+    // else goes through the processors on its own as it arrives.
+    if (!add_to_frame(&data->frame, evt)) {
+        int ret = filter_with_input_config(config, data, apply_event_config, evt);
+
+        if (ret < 0) {
+            LOG_ERR("Error applying input processors: %d", ret);
+            stopped = true;
+        } else if (ret == ZMK_INPUT_PROC_STOP) {
+            stopped = true;
+        } else if (evt->type == INPUT_EV_ABS) {
+            handle_abs_code(config, data, evt);
+        } else {
+            // Processors may have mapped the event to motion or a button
+            struct zmk_input_processor_frame mapped = {0};
+            if (add_to_frame(&mapped, evt)) {
+                handle_frame(data, &mapped);
             }
         }
+    }
 
-        zmk_endpoints_send_mouse_report();
-        zmk_hid_mouse_scroll_set(0, 0);
-        zmk_hid_mouse_movement_set(0, 0);
+    if (!evt->sync) {
+        return;
+    }
 
-        clear_xy_data(&data->mouse.data);
-        clear_xy_data(&data->mouse.wheel_data);
+    if (!frame_is_empty(&data->frame)) {
+        int ret = filter_with_input_config(config, data, apply_frame_config, &data->frame);
 
-        data->mouse.button_set = data->mouse.button_clear = 0;
+        if (ret < 0) {
+            LOG_ERR("Error applying input processors: %d", ret);
+            stopped = true;
+        } else if (ret == ZMK_INPUT_PROC_STOP) {
+            stopped = true;
+        } else {
+            handle_frame(data, &data->frame);
+        }
+
+        data->frame = (struct zmk_input_processor_frame){0};
+    }
+
+    if (stopped) {
+        return;
     }
+
+    send_mouse_report(data);
+
+    clear_xy_data(&data->mouse.data);
+    clear_xy_data(&data->mouse.wheel_data);
+
+    data->mouse.button_set = data->mouse.button_clear = 0;
 }
 
 #endif // VALID_LISTENER_COUNT > 0
@@ -362,7 +563,7 @@ static void input_handler(const struct input_listener_config *config,
 
 #define CHILD_CONFIG(node, parent) SCOPED_PROCESSOR(node, node, parent)
 
-#define OVERRIDE_LAYER_BIT(node, prop, idx) BIT(DT_PROP_BY_IDX(node, prop, idx))
+#define OVERRIDE_LAYER_BIT(node, prop, idx) ZMK_KEYMAP_LAYER_BIT(DT_PROP_BY_IDX(node, prop, idx))
 
 #define IL_OVERRIDE(node, parent)                                                                  \
     {                                                                                              \
@@ -391,9 +592,16 @@ static void input_handler(const struct input_listener_config *config,
                  .layer_override_data = {DT_INST_FOREACH_CHILD_SEP_VARGS(n, IL_OVERRIDE_DATA,      \
                                                                          (, ), n)},                \
              };                                                                                    \
+         BUILD_ASSERT((0 DT_INST_FOREACH_CHILD(n, IL_ONE)) <= 32,                                  \
+                      "An input listener supports at most 32 layer overrides");                    \
          void input_handler_##n(struct input_event *evt) {                                         \
              input_handler(&config_##n, &data_##n, evt);                                           \
-         } INPUT_CALLBACK_DEFINE(DEVICE_DT_GET(DT_INST_PHANDLE(n, device)), input_handler_##n);),  \
+         } INPUT_CALLBACK_DEFINE(DEVICE_DT_GET(DT_INST_PHANDLE(n, device)), input_handler_##n);    \
+         static int input_listener_layer_state_changed_##n(const zmk_event_t *eh) {                \
+             update_active_overrides(&config_##n, &data_##n);                                      \
+             return ZMK_EV_EVENT_BUBBLE;                                                           \
+         } ZMK_LISTENER(input_listener_##n, input_listener_layer_state_changed_##n);               \
+         ZMK_SUBSCRIPTION(input_listener_##n, zmk_layer_state_changed);),                          \
         ())
 
 DT_INST_FOREACH_STATUS_OKAY(IL_INST)
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2025 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <drivers/input_processor.h>
+
+static void collect_frame_event(struct zmk_input_processor_frame *frame,
+                                const struct input_event *evt) {
+    switch (evt->type) {
+    case INPUT_EV_REL: {
+        int axis = zmk_input_processor_frame_axis_for_code(evt->code);
+        if (axis >= 0) {
+            frame->rel[axis] += evt->value;
+            frame->rel_present |= BIT(axis);
+        }
+        break;
+    }
+    case INPUT_EV_KEY:
+        if (evt->code >= INPUT_BTN_0 &&
+            evt->code < INPUT_BTN_0 + ZMK_INPUT_PROCESSOR_FRAME_BUTTONS) {
+            if (evt->value > 0) {
+                frame->buttons_set |= BIT(evt->code - INPUT_BTN_0);
+            } else {
+                frame->buttons_clear |= BIT(evt->code - INPUT_BTN_0);
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static int handle_frame_event(const struct device *dev, struct zmk_input_processor_frame *out,
+                              struct input_event *evt, int16_t *remainder, uint32_t param1,
+                              uint32_t param2,
+                              const struct zmk_input_processor_frame_state *frame_state) {
+    struct zmk_input_processor_state state = {
+        .input_device_index = frame_state->input_device_index,
+        .remainder = remainder,
+    };
+
+    int ret = zmk_input_processor_handle_event(dev, evt, param1, param2, &state);
+    if (ret == ZMK_INPUT_PROC_CONTINUE) {
+        collect_frame_event(out, evt);
+    }
+
+    return ret;
+}
+
+int zmk_input_processor_handle_frame_with_events(const struct device *dev,
+                                                 struct zmk_input_processor_frame *frame,
+                                                 uint32_t param1, uint32_t param2,
+                                                 struct zmk_input_processor_frame_state *state) {
+    struct zmk_input_processor_frame out = {0};
+    bool stopped = false;
+
+    for (int axis = 0; axis < ZMK_INPUT_PROCESSOR_FRAME_AXIS_COUNT; axis++) {
+        if (!(frame->rel_present & BIT(axis))) {
+            continue;
+        }
+
+        struct input_event evt = {
+            .type = INPUT_EV_REL,
+            .code = zmk_input_processor_frame_axis_code(axis),
+            .value = frame->rel[axis],
+        };
+
+        int ret = handle_frame_event(dev, &out, &evt,
+                                     state->remainders ? &state->remainders[axis] : NULL, param1,
+                                     param2, state);
+        if (ret < 0) {
+            return ret;
+        }
+
+        stopped |= ret == ZMK_INPUT_PROC_STOP;
+    }
+
+    for (int btn = 0; btn < ZMK_INPUT_PROCESSOR_FRAME_BUTTONS; btn++) {
+        uint8_t changes[] = {frame->buttons_set, frame->buttons_clear};
+
+        for (int c = 0; c < ARRAY_SIZE(changes); c++) {
+            if (!(changes[c] & BIT(btn))) {
+                continue;
+            }
+
+            struct input_event evt = {
+                .type = INPUT_EV_KEY,
+                .code = INPUT_BTN_0 + btn,
+                .value = (c == 0) ? 1 : 0,
+            };
+
+            int ret = handle_frame_event(dev, &out, &evt, NULL, param1, param2, state);
+            if (ret < 0) {
+                return ret;
+            }
+
+            stopped |= ret == ZMK_INPUT_PROC_STOP;
+        }
+    }
+
+    *frame = out;
+
+    // Nothing is left for the rest of the chain once every event was stopped
+    if (stopped && out.rel_present == 0 && out.buttons_set == 0 && out.buttons_clear == 0) {
+        return ZMK_INPUT_PROC_STOP;
+    }
+
+    return ZMK_INPUT_PROC_CONTINUE;
+}
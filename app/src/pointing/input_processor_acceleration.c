@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2025 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_input_processor_acceleration
+
+#include <stdlib.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <drivers/input_processor.h>
+#include <zmk/input_listeners.h>
+#include <zmk/pointing/curve.h>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+// Gains are in 1/256ths, which is also the resolution of the tracked remainders
+#define GAIN_SHIFT 8
+// Signed, so dividing negative values by it doesn't convert them to unsigned
+#define GAIN_ONE (1 << GAIN_SHIFT)
+
+// Travelled distance is kept in 1/256ths of a count, so small movements still decay smoothly
+#define DISTANCE_SHIFT 8
+
+struct accel_config {
+    // Bit per frame axis among the codes, so frames and motion events skip the codes list
+    uint8_t frame_axes;
+    uint32_t window_ms;
+    uint32_t min_speed;
+    uint32_t max_speed;
+    uint16_t min_gain;
+    uint16_t max_gain;
+    uint8_t acceleration_exponent;
+    uint8_t gain_curve_len;
+    const uint16_t *gain_curve;
+    size_t codes_len;
+    uint16_t codes[];
+};
+
+struct accel_device_state {
+    int64_t last_ticks;
+    // Distance travelled within roughly the last window, decayed linearly with elapsed time
+    uint32_t distance;
+};
+
+struct accel_data {
+    uint32_t window_ticks;
+    // Gains sampled between the min and max speed
+    uint16_t gain_curve[ZMK_POINTING_CURVE_POINTS];
+    struct accel_device_state devices[MAX(ZMK_INPUT_LISTENERS_LEN, 1)];
+};
+
+static bool accel_handles_code(const struct accel_config *cfg, uint16_t code) {
+    int axis = zmk_input_processor_frame_axis_for_code(code);
+    if (axis >= 0) {
+        return (cfg->frame_axes & BIT(axis)) != 0;
+    }
+
+    for (int i = 0; i < cfg->codes_len; i++) {
+        if (cfg->codes[i] == code) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Adds the given movement to the device's travelled distance and returns its speed in counts/s
+static uint32_t update_speed(const struct accel_config *cfg, struct accel_data *data,
+                             uint8_t device_index, uint32_t magnitude) {
+    struct accel_device_state *dev_state = &data->devices[device_index % ARRAY_SIZE(data->devices)];
+    int64_t now = k_uptime_ticks();
+    int64_t elapsed = now - dev_state->last_ticks;
+
+    if (elapsed >= data->window_ticks) {
+        dev_state->distance = 0;
+    } else if (elapsed > 0) {
+        dev_state->distance -= (uint64_t)dev_state->distance * elapsed / data->window_ticks;
+    }
+
+    dev_state->last_ticks = now;
+    dev_state->distance += magnitude << DISTANCE_SHIFT;
+
+    return ((uint64_t)dev_state->distance * MSEC_PER_SEC / cfg->window_ms) >> DISTANCE_SHIFT;
+}
+
+static uint32_t gain_for_speed(const struct accel_config *cfg, const struct accel_data *data,
+                               uint32_t speed) {
+    if (speed <= cfg->min_speed) {
+        return data->gain_curve[0];
+    } else if (speed >= cfg->max_speed) {
+        return data->gain_curve[ZMK_POINTING_CURVE_SEGMENTS];
+    }
+
+    uint32_t range = cfg->max_speed - cfg->min_speed;
+    uint32_t pos = (speed - cfg->min_speed) * ZMK_POINTING_CURVE_SEGMENTS;
+    uint32_t idx = pos / range;
+    uint32_t rem = pos % range;
+
+    int32_t from = data->gain_curve[idx];
+    int32_t to = data->gain_curve[idx + 1];
+
+    return from + (int64_t)(to - from) * rem / range;
+}
+
+static int16_t apply_gain(int16_t value, uint32_t gain, int16_t *remainder) {
+    int32_t value_mul = (int32_t)value * (int32_t)gain;
+
+    if (remainder) {
+        value_mul += *remainder;
+    }
+
+    // Truncate towards zero, keeping what's left for the next event
+    int32_t scaled = value_mul / GAIN_ONE;
+
+    if (remainder) {
+        *remainder = value_mul - (scaled * GAIN_ONE);
+    }
+
+    return CLAMP(scaled, INT16_MIN, INT16_MAX);
+}
+
+static int accel_handle_event(const struct device *dev, struct input_event *event, uint32_t param1,
+                              uint32_t param2, struct zmk_input_processor_state *state) {
+    const struct accel_config *cfg = dev->config;
+    struct accel_data *data = dev->data;
+
+    if (event->type != INPUT_EV_REL || !accel_handles_code(cfg, event->code)) {
+        return ZMK_INPUT_PROC_CONTINUE;
+    }
+
+    uint8_t device_index = state ? state->input_device_index : 0;
+    uint32_t speed = update_speed(cfg, data, device_index, abs(event->value));
+    uint32_t gain = gain_for_speed(cfg, data, speed);
+
+    LOG_DBG("speed %d gives gain %d/%d", speed, gain, GAIN_ONE);
+
+    event->value = apply_gain(event->value, gain, state ? state->remainder : NULL);
+
+    return ZMK_INPUT_PROC_CONTINUE;
+}
+
+static int accel_handle_frame(const struct device *dev, struct zmk_input_processor_frame *frame,
+                              uint32_t param1, uint32_t param2,
+                              struct zmk_input_processor_frame_state *state) {
+    const struct accel_config *cfg = dev->config;
+    struct accel_data *data = dev->data;
+
+    uint8_t axes = frame->rel_present & cfg->frame_axes;
+    if (axes == 0) {
+        return ZMK_INPUT_PROC_CONTINUE;
+    }
+
+    // Approximate the length of the movement as the longest axis plus half of the others
+    uint32_t longest = 0, total = 0;
+    for (int axis = 0; axis < ZMK_INPUT_PROCESSOR_FRAME_AXIS_COUNT; axis++) {
+        if (axes & BIT(axis)) {
+            uint32_t value = abs(frame->rel[axis]);
+            longest = MAX(longest, value);
+            total += value;
+        }
+    }
+
+    uint32_t speed =
+        update_speed(cfg, data, state->input_device_index, longest + (total - longest) / 2);
+    uint32_t gain = gain_for_speed(cfg, data, speed);
+
+    LOG_DBG("speed %d gives gain %d/%d", speed, gain, GAIN_ONE);
+
+    for (int axis = 0; axes != 0; axis++, axes >>= 1) {
+        if (axes & BIT(0)) {
+            frame->rel[axis] = apply_gain(frame->rel[axis], gain,
+                                          state->remainders ? &state->remainders[axis] : NULL);
+        }
+    }
+
+    return ZMK_INPUT_PROC_CONTINUE;
+}
+
+static struct zmk_input_processor_driver_api accel_driver_api = {
+    .handle_event = accel_handle_event,
+    .handle_frame = accel_handle_frame,
+};
+
+static int accel_init(const struct device *dev) {
+    const struct accel_config *cfg = dev->config;
+    struct accel_data *data = dev->data;
+
+    data->window_ticks = k_ms_to_ticks_ceil32(cfg->window_ms);
+
+    // Gains are rounded down to a whole permille before converting them, like custom curve points
+    if (cfg->gain_curve_len > 0) {
+        zmk_pointing_curve_build_from_points(data->gain_curve, cfg->gain_curve, cfg->gain_curve_len,
+                                             1000);
+    } else {
+        zmk_pointing_curve_build_exponent(data->gain_curve, cfg->min_gain, cfg->max_gain,
+                                          cfg->acceleration_exponent, 1000);
+    }
+
+    for (int i = 0; i < ZMK_POINTING_CURVE_POINTS; i++) {
+        data->gain_curve[i] = data->gain_curve[i] * GAIN_ONE / 1000;
+    }
+
+    return 0;
+}
+
+#define ACCEL_CODE_AXIS_BIT(node_id, prop, idx)                                                    \
+    ZMK_INPUT_PROCESSOR_FRAME_AXIS_BIT_FOR_CODE(DT_PROP_BY_IDX(node_id, prop, idx)) |
+
+#define ACCEL_GAIN_CURVE(n)                                                                        \
+    COND_CODE_1(DT_INST_NODE_HAS_PROP(n, gain_curve),                                              \
+                (static const uint16_t accel_gain_curve_##n[] = DT_INST_PROP(n, gain_curve);       \
+                 BUILD_ASSERT(DT_INST_PROP_LEN(n, gain_curve) >= 2,                                \
+                              "A gain curve needs at least two points");                           \
+                 BUILD_ASSERT(DT_INST_PROP_LEN(n, gain_curve) <= UINT8_MAX,                        \
+                              "A gain curve can have at most 255 points");),                       \
+                ())
+
+#define ACCEL_INST(n)                                                                              \
+    ACCEL_GAIN_CURVE(n)                                                                            \
+    BUILD_ASSERT(DT_INST_PROP(n, max_speed) > DT_INST_PROP(n, min_speed),                          \
+                 "The max speed must be greater than the min speed");                              \
+    BUILD_ASSERT(DT_INST_PROP(n, velocity_window_ms) > 0, "The velocity window can't be empty");   \
+    static const struct accel_config accel_config_##n = {                                          \
+        .frame_axes = (DT_INST_FOREACH_PROP_ELEM(n, codes, ACCEL_CODE_AXIS_BIT) 0),                \
+        .window_ms = DT_INST_PROP(n, velocity_window_ms),                                          \
+        .min_speed = DT_INST_PROP(n, min_speed),                                                   \
+        .max_speed = DT_INST_PROP(n, max_speed),                                                   \
+        .min_gain = DT_INST_PROP(n, min_gain),                                                     \
+        .max_gain = DT_INST_PROP(n, max_gain),                                                     \
+        .acceleration_exponent = DT_INST_PROP(n, acceleration_exponent),                           \
+        .gain_curve_len = DT_INST_PROP_LEN_OR(n, gain_curve, 0),                                   \
+        .gain_curve = COND_CODE_1(DT_INST_NODE_HAS_PROP(n, gain_curve),                            \
+                                  (accel_gain_curve_##n), (NULL)),                                 \
+        .codes_len = DT_INST_PROP_LEN(n, codes),                                                   \
+        .codes = DT_INST_PROP(n, codes),                                                           \
+    };                                                                                             \
+    static struct accel_data accel_data_##n;                                                       \
+    DEVICE_DT_INST_DEFINE(n, &accel_init, NULL, &accel_data_##n, &accel_config_##n, POST_KERNEL,   \
+                          CONFIG_KERNEL_INIT_PRIORITY_DEFAULT, &accel_driver_api);
+
+DT_INST_FOREACH_STATUS_OKAY(ACCEL_INST)
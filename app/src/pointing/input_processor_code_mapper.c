@@ -20,6 +20,11 @@ struct cm_config {
     uint16_t mapping[];
 };
 
+struct cm_data {
+    // Frame axis each frame axis is mapped to, or -1 if it's mapped to a code frames can't hold
+    int8_t axis_map[ZMK_INPUT_PROCESSOR_FRAME_AXIS_COUNT];
+};
+
 static int cm_handle_event(const struct device *dev, struct input_event *event, uint32_t param1,
                            uint32_t param2, struct zmk_input_processor_state *state) {
     const struct cm_config *cfg = dev->config;
@@ -40,10 +45,61 @@ static int cm_handle_event(const struct device *dev, struct input_event *event,
     return ZMK_INPUT_PROC_CONTINUE;
 }
 
+static int cm_handle_frame(const struct device *dev, struct zmk_input_processor_frame *frame,
+                           uint32_t param1, uint32_t param2,
+                           struct zmk_input_processor_frame_state *state) {
+    const struct cm_config *cfg = dev->config;
+    const struct cm_data *data = dev->data;
+
+    if (cfg->type != INPUT_EV_REL) {
+        return zmk_input_processor_handle_frame_with_events(dev, frame, param1, param2, state);
+    }
+
+    struct zmk_input_processor_frame mapped = {
+        .buttons_set = frame->buttons_set,
+        .buttons_clear = frame->buttons_clear,
+    };
+
+    for (int axis = 0; axis < ZMK_INPUT_PROCESSOR_FRAME_AXIS_COUNT; axis++) {
+        int8_t to = data->axis_map[axis];
+
+        if ((frame->rel_present & BIT(axis)) && to >= 0) {
+            mapped.rel[to] += frame->rel[axis];
+            mapped.rel_present |= BIT(to);
+        }
+    }
+
+    *frame = mapped;
+
+    return ZMK_INPUT_PROC_CONTINUE;
+}
+
 static struct zmk_input_processor_driver_api cm_driver_api = {
     .handle_event = cm_handle_event,
+    .handle_frame = cm_handle_frame,
 };
 
+static int cm_init(const struct device *dev) {
+    const struct cm_config *cfg = dev->config;
+    struct cm_data *data = dev->data;
+
+    for (int axis = 0; axis < ZMK_INPUT_PROCESSOR_FRAME_AXIS_COUNT; axis++) {
+        uint16_t code = zmk_input_processor_frame_axis_code(axis);
+
+        data->axis_map[axis] = axis;
+
+        for (int i = 0; i < cfg->mapping_size / 2; i++) {
+            if (cfg->mapping[i * 2] == code) {
+                data->axis_map[axis] =
+                    zmk_input_processor_frame_axis_for_code(cfg->mapping[(i * 2) + 1]);
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
 #define TL_INST(n)                                                                                 \
     static const struct cm_config cm_config_##n = {                                                \
         .type = DT_INST_PROP_OR(n, type, INPUT_EV_REL),                                            \
@@ -52,7 +108,8 @@ static struct zmk_input_processor_driver_api cm_driver_api = {
     };                                                                                             \
     BUILD_ASSERT(DT_INST_PROP_LEN(n, map) % 2 == 0,                                                \
                  "Must have an even number of mapping entries");                                   \
-    DEVICE_DT_INST_DEFINE(n, NULL, NULL, NULL, &cm_config_##n, POST_KERNEL,                        \
+    static struct cm_data cm_data_##n;                                                             \
+    DEVICE_DT_INST_DEFINE(n, &cm_init, NULL, &cm_data_##n, &cm_config_##n, POST_KERNEL,            \
                           CONFIG_KERNEL_INIT_PRIORITY_DEFAULT, &cm_driver_api);
 
 DT_INST_FOREACH_STATUS_OKAY(TL_INST)
\ No newline at end of file
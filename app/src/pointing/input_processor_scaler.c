@@ -16,43 +16,75 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 struct scaler_config {
     uint8_t type;
+    // Bit per frame axis among the codes, so frames and motion events skip the codes list
+    uint8_t frame_axes;
     size_t codes_len;
     uint16_t codes[];
 };
 
-static int scale_val(struct input_event *event, uint32_t mul, uint32_t div,
-                     struct zmk_input_processor_state *state) {
-    int16_t value_mul = event->value * (int16_t)mul;
+static int16_t scale_value(int16_t value, uint32_t mul, uint32_t div, int16_t *remainder) {
+    int16_t value_mul = value * (int16_t)mul;
 
-    if (state && state->remainder) {
-        value_mul += *state->remainder;
+    if (remainder) {
+        value_mul += *remainder;
     }
 
     int16_t scaled = value_mul / (int16_t)div;
 
-    if (state && state->remainder) {
-        *state->remainder = value_mul - (scaled * (int16_t)div);
+    if (remainder) {
+        *remainder = value_mul - (scaled * (int16_t)div);
     }
 
-    LOG_DBG("scaled %d with %d/%d to %d with remainder %d", event->value, mul, div, scaled,
-            (state && state->remainder) ? *state->remainder : 0);
+    LOG_DBG("scaled %d with %d/%d to %d with remainder %d", value, mul, div, scaled,
+            remainder ? *remainder : 0);
 
-    event->value = scaled;
+    return scaled;
+}
 
-    return 0;
+static bool scaler_handles_code(const struct scaler_config *cfg, uint16_t code) {
+    if (cfg->type == INPUT_EV_REL) {
+        int axis = zmk_input_processor_frame_axis_for_code(code);
+        if (axis >= 0) {
+            return (cfg->frame_axes & BIT(axis)) != 0;
+        }
+    }
+
+    for (int i = 0; i < cfg->codes_len; i++) {
+        if (cfg->codes[i] == code) {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 static int scaler_handle_event(const struct device *dev, struct input_event *event, uint32_t param1,
                                uint32_t param2, struct zmk_input_processor_state *state) {
     const struct scaler_config *cfg = dev->config;
 
-    if (event->type != cfg->type) {
+    if (event->type != cfg->type || !scaler_handles_code(cfg, event->code)) {
         return ZMK_INPUT_PROC_CONTINUE;
     }
 
-    for (int i = 0; i < cfg->codes_len; i++) {
-        if (cfg->codes[i] == event->code) {
-            return scale_val(event, param1, param2, state);
+    event->value = scale_value(event->value, param1, param2, state ? state->remainder : NULL);
+
+    return ZMK_INPUT_PROC_CONTINUE;
+}
+
+static int scaler_handle_frame(const struct device *dev, struct zmk_input_processor_frame *frame,
+                               uint32_t param1, uint32_t param2,
+                               struct zmk_input_processor_frame_state *state) {
+    const struct scaler_config *cfg = dev->config;
+
+    if (cfg->type != INPUT_EV_REL) {
+        return zmk_input_processor_handle_frame_with_events(dev, frame, param1, param2, state);
+    }
+
+    uint8_t axes = frame->rel_present & cfg->frame_axes;
+    for (int axis = 0; axes != 0; axis++, axes >>= 1) {
+        if (axes & BIT(0)) {
+            frame->rel[axis] = scale_value(frame->rel[axis], param1, param2,
+                                           state->remainders ? &state->remainders[axis] : NULL);
         }
     }
 
@@ -61,11 +93,16 @@ static int scaler_handle_event(const struct device *dev, struct input_event *eve
 
 static struct zmk_input_processor_driver_api scaler_driver_api = {
     .handle_event = scaler_handle_event,
+    .handle_frame = scaler_handle_frame,
 };
 
+#define SCALER_CODE_AXIS_BIT(node_id, prop, idx)                                                   \
+    ZMK_INPUT_PROCESSOR_FRAME_AXIS_BIT_FOR_CODE(DT_PROP_BY_IDX(node_id, prop, idx)) |
+
 #define SCALER_INST(n)                                                                             \
     static const struct scaler_config scaler_config_##n = {                                        \
         .type = DT_INST_PROP_OR(n, type, INPUT_EV_REL),                                            \
+        .frame_axes = (DT_INST_FOREACH_PROP_ELEM(n, codes, SCALER_CODE_AXIS_BIT) 0),               \
         .codes_len = DT_INST_PROP_LEN(n, codes),                                                   \
         .codes = DT_INST_PROP(n, codes),                                                           \
     };                                                                                             \
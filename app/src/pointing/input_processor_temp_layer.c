@@ -228,9 +228,7 @@ static int handle_event_dispatcher(const zmk_event_t *eh) {
 }
 
 /* Driver Implementation */
-static int temp_layer_handle_event(const struct device *dev, struct input_event *event,
-                                   uint32_t param1, uint32_t param2,
-                                   struct zmk_input_processor_state *state) {
+static int temp_layer_handle_input(const struct device *dev, uint32_t param1, uint32_t param2) {
     if (param1 >= MAX_LAYERS) {
         LOG_ERR("Invalid layer index: %d", param1);
         return -EINVAL;
@@ -264,6 +262,18 @@ static int temp_layer_handle_event(const struct device *dev, struct input_event
     return ZMK_INPUT_PROC_CONTINUE;
 }
 
+static int temp_layer_handle_event(const struct device *dev, struct input_event *event,
+                                   uint32_t param1, uint32_t param2,
+                                   struct zmk_input_processor_state *state) {
+    return temp_layer_handle_input(dev, param1, param2);
+}
+
+static int temp_layer_handle_frame(const struct device *dev,
+                                   struct zmk_input_processor_frame *frame, uint32_t param1,
+                                   uint32_t param2, struct zmk_input_processor_frame_state *state) {
+    return temp_layer_handle_input(dev, param1, param2);
+}
+
 static int temp_layer_init(const struct device *dev) {
     struct temp_layer_data *data = (struct temp_layer_data *)dev->data;
     k_mutex_init(&data->lock);
@@ -278,6 +288,7 @@ static int temp_layer_init(const struct device *dev) {
 /* Driver API */
 static const struct zmk_input_processor_driver_api temp_layer_driver_api = {
     .handle_event = temp_layer_handle_event,
+    .handle_frame = temp_layer_handle_frame,
 };
 
 /* Event Listeners Conditions */
@@ -27,6 +27,15 @@ struct ipt_config {
     const uint16_t *y_codes;
 };
 
+struct ipt_data {
+    // Frame axes of the x and y codes, and the axis each frame axis is swapped with
+    uint8_t x_axes;
+    uint8_t y_axes;
+    int8_t swap_axis[ZMK_INPUT_PROCESSOR_FRAME_AXIS_COUNT];
+    // Whether no axis is swapped with a code frames can't hold
+    bool frame_capable;
+};
+
 static int code_idx(uint16_t code, const uint16_t *list, size_t len) {
     for (int i = 0; i < len; i++) {
         if (list[i] == code) {
@@ -68,11 +77,82 @@ static int ipt_handle_event(const struct device *dev, struct input_event *event,
     return ZMK_INPUT_PROC_CONTINUE;
 }
 
+static int ipt_handle_frame(const struct device *dev, struct zmk_input_processor_frame *frame,
+                            uint32_t param1, uint32_t param2,
+                            struct zmk_input_processor_frame_state *state) {
+    const struct ipt_config *cfg = dev->config;
+    const struct ipt_data *data = dev->data;
+
+    if (cfg->type != INPUT_EV_REL || !data->frame_capable) {
+        return zmk_input_processor_handle_frame_with_events(dev, frame, param1, param2, state);
+    }
+
+    if (param1 & INPUT_TRANSFORM_XY_SWAP) {
+        struct zmk_input_processor_frame swapped = *frame;
+
+        swapped.rel_present = 0;
+        for (int axis = 0; axis < ZMK_INPUT_PROCESSOR_FRAME_AXIS_COUNT; axis++) {
+            if (frame->rel_present & BIT(axis)) {
+                swapped.rel[data->swap_axis[axis]] = frame->rel[axis];
+                swapped.rel_present |= BIT(data->swap_axis[axis]);
+            }
+        }
+
+        *frame = swapped;
+    }
+
+    uint8_t invert_axes = ((param1 & INPUT_TRANSFORM_X_INVERT) ? data->x_axes : 0) |
+                          ((param1 & INPUT_TRANSFORM_Y_INVERT) ? data->y_axes : 0);
+
+    invert_axes &= frame->rel_present;
+    for (int axis = 0; invert_axes != 0; axis++, invert_axes >>= 1) {
+        if (invert_axes & BIT(0)) {
+            frame->rel[axis] = -frame->rel[axis];
+        }
+    }
+
+    return ZMK_INPUT_PROC_CONTINUE;
+}
+
 static struct zmk_input_processor_driver_api ipt_driver_api = {
     .handle_event = ipt_handle_event,
+    .handle_frame = ipt_handle_frame,
 };
 
-static int ipt_init(const struct device *dev) { return 0; }
+static int ipt_init(const struct device *dev) {
+    const struct ipt_config *cfg = dev->config;
+    struct ipt_data *data = dev->data;
+
+    data->frame_capable = true;
+
+    // Resolve each axis with the same lookups single events use
+    for (int axis = 0; axis < ZMK_INPUT_PROCESSOR_FRAME_AXIS_COUNT; axis++) {
+        uint16_t code = zmk_input_processor_frame_axis_code(axis);
+        int x_idx = code_idx(code, cfg->x_codes, cfg->x_codes_size);
+        int y_idx = code_idx(code, cfg->y_codes, cfg->y_codes_size);
+        int swap_axis = axis;
+
+        if (x_idx >= 0) {
+            data->x_axes |= BIT(axis);
+            swap_axis = zmk_input_processor_frame_axis_for_code(cfg->y_codes[x_idx]);
+        } else if (y_idx >= 0) {
+            swap_axis = zmk_input_processor_frame_axis_for_code(cfg->x_codes[y_idx]);
+        }
+
+        if (y_idx >= 0) {
+            data->y_axes |= BIT(axis);
+        }
+
+        if (swap_axis < 0) {
+            data->frame_capable = false;
+            swap_axis = axis;
+        }
+
+        data->swap_axis[axis] = swap_axis;
+    }
+
+    return 0;
+}
 
 #define IPT_INST(n)                                                                                \
     static const uint16_t ipt_x_codes_##n[] = DT_INST_PROP(n, x_codes);                            \
@@ -86,7 +166,8 @@ static int ipt_init(const struct device *dev) { return 0; }
         .x_codes = ipt_x_codes_##n,                                                                \
         .y_codes = ipt_y_codes_##n,                                                                \
     };                                                                                             \
-    DEVICE_DT_INST_DEFINE(n, &ipt_init, NULL, NULL, &ipt_config_##n, POST_KERNEL,                  \
+    static struct ipt_data ipt_data_##n;                                                           \
+    DEVICE_DT_INST_DEFINE(n, &ipt_init, NULL, &ipt_data_##n, &ipt_config_##n, POST_KERNEL,         \
                           CONFIG_KERNEL_INIT_PRIORITY_DEFAULT, &ipt_driver_api);
 
 DT_INST_FOREACH_STATUS_OKAY(IPT_INST)
\ No newline at end of file
@@ -9,8 +9,8 @@
 #include <zephyr/kernel.h>
 #include <zephyr/settings/settings.h>
 
-#include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <zephyr/logging/log.h>
 
@@ -26,6 +26,17 @@
 #include <zmk/events/usb_conn_state_changed.h>
 #include <zmk/workqueue.h>
 
+#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_PER_KEY)
+#include <zmk/physical_layouts.h>
+#include <zmk/events/position_state_changed.h>
+#endif // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_PER_KEY)
+
+#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+#include <zmk/behavior.h>
+#include <zmk/keymap.h>
+#include <zmk/events/layer_state_changed.h>
+#endif // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #if !DT_HAS_CHOSEN(zmk_underglow)
@@ -41,6 +52,11 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #define SAT_MAX 100
 #define BRT_MAX 100
 
+#define UNDERGLOW_TICK_MS 50
+
+// Late ticks are caught up on up to this many at once
+#define UNDERGLOW_MAX_CATCH_UP_TICKS 4
+
 BUILD_ASSERT(CONFIG_ZMK_RGB_UNDERGLOW_BRT_MIN <= CONFIG_ZMK_RGB_UNDERGLOW_BRT_MAX,
              "ERROR: RGB underglow maximum brightness is less than minimum brightness");
 
@@ -64,6 +80,10 @@ static const struct device *led_strip;
 
 static struct led_rgb pixels[STRIP_NUM_PIXELS];
 
+// Copy of the last frame sent to the strip, drivers are allowed to overwrite the buffer they get
+static struct led_rgb sent_pixels[STRIP_NUM_PIXELS];
+static bool sent_pixels_valid;
+
 static struct rgb_underglow_state state;
 
 #if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_EXT_POWER)
@@ -82,68 +102,51 @@ static struct zmk_led_hsb hsb_scale_zero_max(struct zmk_led_hsb hsb) {
 }
 
 static struct led_rgb hsb_to_rgb(struct zmk_led_hsb hsb) {
-    float r = 0, g = 0, b = 0;
-
+    // Integer version of the usual HSV sector conversion, with f = rem / 60. Every channel is
+    // v * (1 - x * s) for some x, scaled up so that a single division at the end is exact enough.
     uint8_t i = hsb.h / 60;
-    float v = hsb.b / ((float)BRT_MAX);
-    float s = hsb.s / ((float)SAT_MAX);
-    float f = hsb.h / ((float)HUE_MAX) * 6 - i;
-    float p = v * (1 - s);
-    float q = v * (1 - f * s);
-    float t = v * (1 - (1 - f) * s);
+    uint32_t rem = hsb.h % 60;
+    uint32_t v = hsb.b * 255;
+
+    uint8_t max = v / BRT_MAX;
+    uint8_t p = v * (SAT_MAX - hsb.s) / (BRT_MAX * SAT_MAX);
+    uint8_t q = v * (60 * SAT_MAX - rem * hsb.s) / (60 * BRT_MAX * SAT_MAX);
+    uint8_t t = v * (60 * SAT_MAX - (60 - rem) * hsb.s) / (60 * BRT_MAX * SAT_MAX);
 
     switch (i % 6) {
     case 0:
-        r = v;
-        g = t;
-        b = p;
-        break;
+        return (struct led_rgb){r : max, g : t, b : p};
     case 1:
-        r = q;
-        g = v;
-        b = p;
-        break;
+        return (struct led_rgb){r : q, g : max, b : p};
     case 2:
-        r = p;
-        g = v;
-        b = t;
-        break;
+        return (struct led_rgb){r : p, g : max, b : t};
     case 3:
-        r = p;
-        g = q;
-        b = v;
-        break;
+        return (struct led_rgb){r : p, g : q, b : max};
     case 4:
-        r = t;
-        g = p;
-        b = v;
-        break;
-    case 5:
-        r = v;
-        g = p;
-        b = q;
-        break;
+        return (struct led_rgb){r : t, g : p, b : max};
+    default:
+        return (struct led_rgb){r : max, g : p, b : q};
     }
-
-    struct led_rgb rgb = {r : r * 255, g : g * 255, b : b * 255};
-
-    return rgb;
 }
 
-static void zmk_rgb_underglow_effect_solid(void) {
+static void fill_pixels(struct led_rgb rgb) {
     for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-        pixels[i] = hsb_to_rgb(hsb_scale_min_max(state.color));
+        pixels[i] = rgb;
     }
 }
 
+static void zmk_rgb_underglow_effect_solid(void) {
+    fill_pixels(hsb_to_rgb(hsb_scale_min_max(state.color)));
+}
+
 static void zmk_rgb_underglow_effect_breathe(void) {
-    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-        struct zmk_led_hsb hsb = state.color;
-        hsb.b = abs(state.animation_step - 1200) / 12;
+    struct zmk_led_hsb hsb = state.color;
+    hsb.b = abs(state.animation_step - 1200) / 12;
 
-        pixels[i] = hsb_to_rgb(hsb_scale_zero_max(hsb));
-    }
+    fill_pixels(hsb_to_rgb(hsb_scale_zero_max(hsb)));
+}
 
+static void zmk_rgb_underglow_effect_breathe_advance(void) {
     state.animation_step += state.animation_speed * 10;
 
     if (state.animation_step > 2400) {
@@ -152,13 +155,13 @@ static void zmk_rgb_underglow_effect_breathe(void) {
 }
 
 static void zmk_rgb_underglow_effect_spectrum(void) {
-    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-        struct zmk_led_hsb hsb = state.color;
-        hsb.h = state.animation_step;
+    struct zmk_led_hsb hsb = state.color;
+    hsb.h = state.animation_step;
 
-        pixels[i] = hsb_to_rgb(hsb_scale_min_max(hsb));
-    }
+    fill_pixels(hsb_to_rgb(hsb_scale_min_max(hsb)));
+}
 
+static void zmk_rgb_underglow_effect_spectrum_advance(void) {
     state.animation_step += state.animation_speed;
     state.animation_step = state.animation_step % HUE_MAX;
 }
@@ -170,44 +173,188 @@ static void zmk_rgb_underglow_effect_swirl(void) {
 
         pixels[i] = hsb_to_rgb(hsb_scale_min_max(hsb));
     }
+}
 
+static void zmk_rgb_underglow_effect_swirl_advance(void) {
     state.animation_step += state.animation_speed * 2;
     state.animation_step = state.animation_step % HUE_MAX;
 }
 
-static void zmk_rgb_underglow_tick(struct k_work *work) {
-    switch (state.current_effect) {
-    case UNDERGLOW_EFFECT_SOLID:
-        zmk_rgb_underglow_effect_solid();
-        break;
-    case UNDERGLOW_EFFECT_BREATHE:
-        zmk_rgb_underglow_effect_breathe();
-        break;
-    case UNDERGLOW_EFFECT_SPECTRUM:
-        zmk_rgb_underglow_effect_spectrum();
-        break;
-    case UNDERGLOW_EFFECT_SWIRL:
-        zmk_rgb_underglow_effect_swirl();
-        break;
+struct rgb_underglow_effect_def {
+    void (*render)(void);
+    // Moves the animation on by one tick. Static effects have none, they only depend on the
+    // state, so they're rendered once per state change instead of on every tick
+    void (*advance)(void);
+};
+
+static const struct rgb_underglow_effect_def effects[] = {
+    [UNDERGLOW_EFFECT_SOLID] = {.render = zmk_rgb_underglow_effect_solid},
+    [UNDERGLOW_EFFECT_BREATHE] = {.render = zmk_rgb_underglow_effect_breathe,
+                                  .advance = zmk_rgb_underglow_effect_breathe_advance},
+    [UNDERGLOW_EFFECT_SPECTRUM] = {.render = zmk_rgb_underglow_effect_spectrum,
+                                   .advance = zmk_rgb_underglow_effect_spectrum_advance},
+    [UNDERGLOW_EFFECT_SWIRL] = {.render = zmk_rgb_underglow_effect_swirl,
+                                .advance = zmk_rgb_underglow_effect_swirl_advance},
+};
+
+BUILD_ASSERT(ARRAY_SIZE(effects) == UNDERGLOW_EFFECT_NUMBER,
+             "Every underglow effect needs an entry in the effects table");
+
+#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_PER_KEY)
+
+#define PER_KEY_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(zmk_underglow_per_key)
+
+// LED under each key position of the stock physical layout, anything past the strip means none
+static const uint16_t key_leds[] = DT_PROP(PER_KEY_NODE, key_leds);
+
+// Set from the event listener while a key is held, the tick turns these into reactive levels
+static ATOMIC_DEFINE(reactive_held, STRIP_NUM_PIXELS);
+
+// Only touched by work items on the low priority queue, so no locking is needed
+static uint8_t reactive_levels[STRIP_NUM_PIXELS];
+
+#define REACTIVE_LEVEL_MAX UINT8_MAX
+#define REACTIVE_FADE_STEP                                                                         \
+    MAX(REACTIVE_LEVEL_MAX * UNDERGLOW_TICK_MS / CONFIG_ZMK_RGB_UNDERGLOW_REACTIVE_FADE_MS, 1)
+
+#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+static ATOMIC_DEFINE(layer_indicator_leds, STRIP_NUM_PIXELS);
+static uint16_t layer_indicator_hue;
+#endif // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+
+static int led_for_position(uint32_t position) {
+    const uint32_t *pos_map;
+    int len = zmk_physical_layouts_get_selected_to_stock_position_map(&pos_map);
+
+    if (len < 0 || position >= len || pos_map[position] >= ARRAY_SIZE(key_leds)) {
+        return -ENOENT;
     }
 
-    int err = led_strip_update_rgb(led_strip, pixels, STRIP_NUM_PIXELS);
-    if (err < 0) {
-        LOG_ERR("Failed to update the RGB strip (%d)", err);
+    uint16_t led = key_leds[pos_map[position]];
+
+    return led < STRIP_NUM_PIXELS ? led : -ENOENT;
+}
+
+static struct led_rgb blend(struct led_rgb from, struct led_rgb to, uint8_t level) {
+    return (struct led_rgb){
+        r : from.r + (to.r - from.r) * level / REACTIVE_LEVEL_MAX,
+        g : from.g + (to.g - from.g) * level / REACTIVE_LEVEL_MAX,
+        b : from.b + (to.b - from.b) * level / REACTIVE_LEVEL_MAX,
+    };
+}
+
+// Merges the per-key overlays on top of the rendered effect after fading them by the given number
+// of ticks, returns whether they're animating
+static bool apply_per_key_overlays(uint32_t ticks) {
+    bool animating = false;
+
+    struct zmk_led_hsb reactive_hsb = state.color;
+    reactive_hsb.h = (reactive_hsb.h + HUE_MAX / 2) % HUE_MAX;
+    struct led_rgb reactive = hsb_to_rgb(hsb_scale_min_max(reactive_hsb));
+
+#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+    struct zmk_led_hsb indicator_hsb = state.color;
+    indicator_hsb.h = layer_indicator_hue;
+    indicator_hsb.s = SAT_MAX;
+    struct led_rgb indicator = hsb_to_rgb(hsb_scale_min_max(indicator_hsb));
+#endif // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+
+    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
+        uint8_t *level = &reactive_levels[i];
+
+        if (atomic_test_bit(reactive_held, i)) {
+            *level = REACTIVE_LEVEL_MAX;
+        } else if (*level > 0) {
+            uint32_t fade = REACTIVE_FADE_STEP * ticks;
+            *level = *level > fade ? *level - fade : 0;
+            animating = true;
+        }
+
+#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+        if (atomic_test_bit(layer_indicator_leds, i)) {
+            pixels[i] = indicator;
+        }
+#endif // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+
+        if (*level > 0) {
+            pixels[i] = blend(pixels[i], reactive, *level);
+        }
     }
+
+    return animating;
 }
 
-K_WORK_DEFINE(underglow_tick_work, zmk_rgb_underglow_tick);
+#else
+
+static inline bool apply_per_key_overlays(uint32_t ticks) { return false; }
+
+#endif // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_PER_KEY)
+
+static void zmk_rgb_underglow_tick(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(underglow_tick_work, zmk_rgb_underglow_tick);
+
+// Start of the current animation tick. Frames requested by events in between only re-compose the
+// overlays, so the animations keep their speed no matter how often those come in.
+static int64_t animation_tick_start;
+
+static uint32_t elapsed_animation_ticks(int64_t now) {
+    uint32_t ticks = (now - animation_tick_start) / UNDERGLOW_TICK_MS;
+
+    if (ticks > UNDERGLOW_MAX_CATCH_UP_TICKS) {
+        // Nothing was animating for a while, start over instead of replaying the pause
+        animation_tick_start = now;
+        return 1;
+    }
 
-static void zmk_rgb_underglow_tick_handler(struct k_timer *timer) {
+    animation_tick_start += ticks * UNDERGLOW_TICK_MS;
+    return ticks;
+}
+
+static void zmk_rgb_underglow_tick(struct k_work *work) {
     if (!state.on) {
         return;
     }
 
-    k_work_submit_to_queue(zmk_workqueue_lowprio_work_q(), &underglow_tick_work);
+    const struct rgb_underglow_effect_def *effect = &effects[state.current_effect];
+    int64_t now = k_uptime_get();
+    uint32_t ticks = elapsed_animation_ticks(now);
+
+    if (effect->advance) {
+        for (uint32_t i = 0; i < ticks; i++) {
+            effect->advance();
+        }
+    }
+
+    effect->render();
+
+    // Frames are only scheduled at the tick rate while something is animating, anything else that
+    // changes the output, or needs the strip repainted, requests a frame of its own
+    bool animating = apply_per_key_overlays(ticks) || effect->advance != NULL;
+    if (animating) {
+        k_work_schedule_for_queue(zmk_workqueue_lowprio_work_q(), &underglow_tick_work,
+                                  K_MSEC(animation_tick_start + UNDERGLOW_TICK_MS - now));
+    }
+
+    if (sent_pixels_valid && memcmp(pixels, sent_pixels, sizeof(pixels)) == 0) {
+        return;
+    }
+
+    memcpy(sent_pixels, pixels, sizeof(pixels));
+    sent_pixels_valid = true;
+
+    int err = led_strip_update_rgb(led_strip, pixels, STRIP_NUM_PIXELS);
+    if (err < 0) {
+        LOG_ERR("Failed to update the RGB strip (%d)", err);
+    }
 }
 
-K_TIMER_DEFINE(underglow_tick, zmk_rgb_underglow_tick_handler, NULL);
+static void request_frame(void) {
+    if (state.on) {
+        k_work_reschedule_for_queue(zmk_workqueue_lowprio_work_q(), &underglow_tick_work,
+                                    K_NO_WAIT);
+    }
+}
 
 #if IS_ENABLED(CONFIG_SETTINGS)
 static int rgb_settings_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg) {
@@ -221,9 +368,7 @@ static int rgb_settings_set(const char *name, size_t len, settings_read_cb read_
 
         rc = read_cb(cb_arg, &state, sizeof(state));
         if (rc >= 0) {
-            if (state.on) {
-                k_timer_start(&underglow_tick, K_NO_WAIT, K_MSEC(50));
-            }
+            request_frame();
 
             return 0;
         }
@@ -273,9 +418,7 @@ static int zmk_rgb_underglow_init(void) {
     state.on = zmk_usb_is_powered();
 #endif
 
-    if (state.on) {
-        k_timer_start(&underglow_tick, K_NO_WAIT, K_MSEC(50));
-    }
+    request_frame();
 
     return 0;
 }
@@ -289,6 +432,16 @@ int zmk_rgb_underglow_save_state(void) {
 #endif
 }
 
+int zmk_rgb_underglow_refresh(void) {
+    if (!led_strip)
+        return -ENODEV;
+
+    sent_pixels_valid = false;
+    request_frame();
+
+    return 0;
+}
+
 int zmk_rgb_underglow_get_state(bool *on_off) {
     if (!led_strip)
         return -ENODEV;
@@ -312,7 +465,9 @@ int zmk_rgb_underglow_on(void) {
 
     state.on = true;
     state.animation_step = 0;
-    k_timer_start(&underglow_tick, K_NO_WAIT, K_MSEC(50));
+    // The strip may have been powered down together with the underglow
+    sent_pixels_valid = false;
+    request_frame();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -323,6 +478,7 @@ static void zmk_rgb_underglow_off_handler(struct k_work *work) {
     }
 
     led_strip_update_rgb(led_strip, pixels, STRIP_NUM_PIXELS);
+    sent_pixels_valid = false;
 }
 
 K_WORK_DEFINE(underglow_off_work, zmk_rgb_underglow_off_handler);
@@ -342,8 +498,8 @@ int zmk_rgb_underglow_off(void) {
 
     k_work_submit_to_queue(zmk_workqueue_lowprio_work_q(), &underglow_off_work);
 
-    k_timer_stop(&underglow_tick);
     state.on = false;
+    k_work_cancel_delayable(&underglow_tick_work);
 
     return zmk_rgb_underglow_save_state();
 }
@@ -362,6 +518,7 @@ int zmk_rgb_underglow_select_effect(int effect) {
 
     state.current_effect = effect;
     state.animation_step = 0;
+    request_frame();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -380,6 +537,7 @@ int zmk_rgb_underglow_set_hsb(struct zmk_led_hsb color) {
     }
 
     state.color = color;
+    request_frame();
 
     return 0;
 }
@@ -421,6 +579,7 @@ int zmk_rgb_underglow_change_hue(int direction) {
         return -ENODEV;
 
     state.color = zmk_rgb_underglow_calc_hue(direction);
+    request_frame();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -430,6 +589,7 @@ int zmk_rgb_underglow_change_sat(int direction) {
         return -ENODEV;
 
     state.color = zmk_rgb_underglow_calc_sat(direction);
+    request_frame();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -439,6 +599,7 @@ int zmk_rgb_underglow_change_brt(int direction) {
         return -ENODEV;
 
     state.color = zmk_rgb_underglow_calc_brt(direction);
+    request_frame();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -457,6 +618,8 @@ int zmk_rgb_underglow_change_spd(int direction) {
         state.animation_speed = 5;
     }
 
+    request_frame();
+
     return zmk_rgb_underglow_save_state();
 }
 
@@ -520,4 +683,82 @@ ZMK_SUBSCRIPTION(rgb_underglow, zmk_activity_state_changed);
 ZMK_SUBSCRIPTION(rgb_underglow, zmk_usb_conn_state_changed);
 #endif
 
+#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+
+static bool binding_is_indicated(const struct zmk_behavior_binding *binding) {
+    if (!binding) {
+        return false;
+    }
+
+    const struct device *dev = zmk_behavior_get_binding(binding->behavior_dev);
+
+    return dev && dev != DEVICE_DT_GET_OR_NULL(DT_NODELABEL(trans)) &&
+           dev != DEVICE_DT_GET_OR_NULL(DT_NODELABEL(none));
+}
+
+static int mark_layer_indicator(uint16_t binding_idx, const struct zmk_behavior_binding *binding,
+                                void *user_data) {
+    if (binding_is_indicated(binding)) {
+        int led = led_for_position(binding_idx);
+        if (led >= 0) {
+            atomic_set_bit(layer_indicator_leds, led);
+        }
+    }
+
+    return 0;
+}
+
+static void update_layer_indicators(struct k_work *work) {
+    zmk_keymap_layer_index_t highest = zmk_keymap_highest_layer_active();
+    zmk_keymap_layer_id_t layer = zmk_keymap_layer_index_to_id(highest);
+
+    for (int i = 0; i < ATOMIC_BITMAP_SIZE(STRIP_NUM_PIXELS); i++) {
+        atomic_clear(&layer_indicator_leds[i]);
+    }
+
+    // The default layer is what the underglow effect itself stands for
+    if (layer != zmk_keymap_layer_default()) {
+        layer_indicator_hue = (uint32_t)highest * HUE_MAX / ZMK_KEYMAP_LAYERS_LEN;
+        zmk_keymap_foreach_layer_binding(layer, mark_layer_indicator, NULL);
+    }
+
+    request_frame();
+}
+
+K_WORK_DEFINE(layer_indicator_work, update_layer_indicators);
+
+#endif // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+
+#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_PER_KEY)
+
+static int rgb_underglow_per_key_listener(const zmk_event_t *eh) {
+    const struct zmk_position_state_changed *pos_ev = as_zmk_position_state_changed(eh);
+    if (pos_ev) {
+        int led = led_for_position(pos_ev->position);
+        if (led >= 0) {
+            atomic_set_bit_to(reactive_held, led, pos_ev->state);
+            request_frame();
+        }
+
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+    if (as_zmk_layer_state_changed(eh)) {
+        k_work_submit_to_queue(zmk_workqueue_lowprio_work_q(), &layer_indicator_work);
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(rgb_underglow_per_key, rgb_underglow_per_key_listener);
+ZMK_SUBSCRIPTION(rgb_underglow_per_key, zmk_position_state_changed);
+
+#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+ZMK_SUBSCRIPTION(rgb_underglow_per_key, zmk_layer_state_changed);
+#endif // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_LAYER_INDICATORS)
+
+#endif // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_PER_KEY)
+
 SYS_INIT(zmk_rgb_underglow_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -7,6 +7,9 @@
 #include <zephyr/types.h>
 #include <zephyr/init.h>
 
+#include <stdio.h>
+#include <stdlib.h>
+
 #include <zephyr/bluetooth/bluetooth.h>
 #include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/uuid.h>
@@ -22,10 +25,12 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/stdlib.h>
 #include <zmk/ble.h>
 #include <zmk/behavior.h>
+#include <zmk/matrix.h>
 #include <zmk/sensors.h>
 #include <zmk/split/transport/central.h>
 #include <zmk/split/bluetooth/uuid.h>
 #include <zmk/split/bluetooth/service.h>
+#include <zmk/split/bluetooth/central.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/position_state_changed.h>
 #include <zmk/events/sensor_event.h>
@@ -33,10 +38,14 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/pointing/input_split.h>
 #include <zmk/hid_indicators_types.h>
 #include <zmk/physical_layouts.h>
+#include <zmk/telemetry.h>
 
 static int start_scanning(void);
 
-#define POSITION_STATE_DATA_LEN 16
+// Large enough for every position of the keymap, and no smaller than the legacy full state
+#define POSITION_STATE_DATA_LEN                                                                    \
+    MAX(ZMK_SPLIT_POS_STATE_LEGACY_LEN,                                                            \
+        ROUND_UP(DIV_ROUND_UP(ZMK_KEYMAP_LEN, 8), ZMK_SPLIT_POS_STATE_SEGMENT_LEN))
 
 enum peripheral_slot_state {
     PERIPHERAL_SLOT_STATE_OPEN,
@@ -49,19 +58,35 @@ struct peripheral_slot {
     struct bt_conn *conn;
     struct bt_gatt_discover_params discover_params;
     struct bt_gatt_subscribe_params subscribe_params;
-    struct bt_gatt_subscribe_params sensor_subscribe_params;
     struct bt_gatt_discover_params sub_discover_params;
+#if ZMK_KEYMAP_HAS_SENSORS
+    struct bt_gatt_subscribe_params sensor_subscribe_params;
+    struct bt_gatt_discover_params sensor_sub_discover_params;
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
     uint16_t run_behavior_handle;
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
     struct bt_gatt_subscribe_params batt_lvl_subscribe_params;
+    struct bt_gatt_discover_params batt_lvl_sub_discover_params;
     struct bt_gatt_read_params batt_lvl_read_params;
 #endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
     uint16_t update_hid_indicators;
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
     uint16_t selected_physical_layout_handle;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    struct bt_gatt_subscribe_params clock_sync_subscribe_params;
+    struct bt_gatt_discover_params clock_sync_sub_discover_params;
+    uint16_t clock_sync_handle;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+    bool discovery_complete;
+    struct bt_gatt_read_params db_hash_read_params;
+    uint8_t db_hash[16];
+    bool db_hash_valid;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+    int64_t connected_at;
+    struct zmk_split_bt_central_connection_stats stats;
     uint8_t position_state[POSITION_STATE_DATA_LEN];
-    uint8_t changed_positions[POSITION_STATE_DATA_LEN];
 };
 
 #if IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
@@ -190,27 +215,25 @@ int release_peripheral_slot(int index) {
 
     // Raise events releasing any active positions from this peripheral
     for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
-        for (int j = 0; j < 8; j++) {
-            if (slot->position_state[i] & BIT(j)) {
-                uint32_t position = (i * 8) + j;
-                struct peripheral_event_wrapper ev = {
-                    .source = index,
-                    .event = {.type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT,
-                              .data = {.key_position_event = {
-                                           .position = position,
-                                           .pressed = false,
-                                       }}}};
-
-                k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT);
-                k_work_submit(&peripheral_event_work);
-            }
+        uint8_t pressed = slot->position_state[i];
+        while (pressed) {
+            uint16_t position = (i * 8) + __builtin_ctz(pressed);
+            pressed &= pressed - 1;
+
+            struct peripheral_event_wrapper ev = {
+                .source = index,
+                .event = {.type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT,
+                          .data = {.key_position_event = {
+                                       .position = position,
+                                       .pressed = false,
+                                   }}}};
+
+            k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT);
+            k_work_submit(&peripheral_event_work);
         }
     }
 
-    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
-        slot->position_state[i] = 0U;
-        slot->changed_positions[i] = 0U;
-    }
+    memset(slot->position_state, 0, sizeof(slot->position_state));
 
     // Clean up previously discovered handles;
     slot->subscribe_params.value_handle = 0;
@@ -219,6 +242,13 @@ int release_peripheral_slot(int index) {
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
     slot->update_hid_indicators = 0;
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    slot->clock_sync_handle = 0;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+    slot->discovery_complete = false;
+    slot->db_hash_valid = false;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
 
     return 0;
 }
@@ -346,6 +376,35 @@ static uint8_t peripheral_input_event_notify_cb(struct bt_conn *conn,
 
 #endif
 
+// Applies a range of the peripheral's position state, raising events only for the positions that
+// changed. Unchanged bytes cost a single compare, so large states stay cheap to diff.
+static void split_central_update_position_state(struct peripheral_slot *slot, uint8_t source,
+                                                uint16_t offset, const uint8_t *state,
+                                                size_t len, uint32_t timestamp) {
+    for (size_t i = 0; i < len; i++) {
+        uint8_t changed = state[i] ^ slot->position_state[offset + i];
+        slot->position_state[offset + i] = state[i];
+
+        while (changed) {
+            uint8_t bit = __builtin_ctz(changed);
+            changed &= changed - 1;
+
+            struct peripheral_event_wrapper ev = {
+                .source = source,
+                .event = {.type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT,
+                          .data = {.key_position_event = {
+                                       .position = ((offset + i) * 8) + bit,
+                                       .pressed = (state[i] & BIT(bit)) != 0,
+                                       .timestamp = timestamp,
+                                   }}}};
+            k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT);
+            k_work_submit(&peripheral_event_work);
+        }
+    }
+
+    LOG_HEXDUMP_DBG(&slot->position_state[offset], len, "data");
+}
+
 static uint8_t split_central_notify_func(struct bt_conn *conn,
                                          struct bt_gatt_subscribe_params *params, const void *data,
                                          uint16_t length) {
@@ -364,33 +423,78 @@ static uint8_t split_central_notify_func(struct bt_conn *conn,
 
     LOG_DBG("[NOTIFICATION] data %p length %u", data, length);
 
-    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
-        slot->changed_positions[i] = ((uint8_t *)data)[i] ^ slot->position_state[i];
-        slot->position_state[i] = ((uint8_t *)data)[i];
+    if (slot->stats.time_to_first_key < 0) {
+        slot->stats.time_to_first_key = k_uptime_get() - slot->connected_at;
+        LOG_DBG("First key position notification %d ms after connecting",
+                slot->stats.time_to_first_key);
     }
-    LOG_HEXDUMP_DBG(slot->position_state, POSITION_STATE_DATA_LEN, "data");
 
-    for (int i = 0; i < POSITION_STATE_DATA_LEN; i++) {
-        for (int j = 0; j < 8; j++) {
-            if (slot->changed_positions[i] & BIT(j)) {
-                uint32_t position = (i * 8) + j;
-                bool pressed = slot->position_state[i] & BIT(j);
-                struct peripheral_event_wrapper ev = {
-                    .source = peripheral_slot_index_for_conn(conn),
-                    .event = {.type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT,
-                              .data = {.key_position_event = {
-                                           .position = position,
-                                           .pressed = pressed,
-                                       }}}};
-                k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT);
-                k_work_submit(&peripheral_event_work);
-            }
+    uint8_t source = peripheral_slot_index_for_conn(conn);
+
+    if (length == sizeof(struct zmk_split_position_state_segment)) {
+        struct zmk_split_position_state_segment segment;
+        memcpy(&segment, data, sizeof(segment));
+
+        uint16_t offset = sys_le16_to_cpu(segment.offset);
+        if (offset > POSITION_STATE_DATA_LEN - sizeof(segment.state)) {
+            LOG_WRN("Ignoring position state segment beyond the keymap (offset %d)", offset);
+            return BT_GATT_ITER_CONTINUE;
+        }
+
+        split_central_update_position_state(slot, source, offset, segment.state,
+                                            sizeof(segment.state),
+                                            sys_le32_to_cpu(segment.timestamp));
+    } else if (length >= ZMK_SPLIT_POS_STATE_LEGACY_LEN) {
+        // Peripherals with clock sync append the time the state was captured
+        uint32_t timestamp = 0;
+        if (length >= ZMK_SPLIT_POS_STATE_LEGACY_LEN + sizeof(uint32_t)) {
+            timestamp = sys_get_le32((uint8_t *)data + ZMK_SPLIT_POS_STATE_LEGACY_LEN);
         }
+
+        split_central_update_position_state(slot, source, 0, data,
+                                            ZMK_SPLIT_POS_STATE_LEGACY_LEN, timestamp);
+    } else {
+        LOG_WRN("Ignoring position state notify with insufficient data length (%d)", length);
+    }
+
+    return BT_GATT_ITER_CONTINUE;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+
+static uint8_t split_central_clock_sync_notify_func(struct bt_conn *conn,
+                                                    struct bt_gatt_subscribe_params *params,
+                                                    const void *data, uint16_t length) {
+    if (!data) {
+        LOG_DBG("[UNSUBSCRIBED]");
+        params->value_handle = 0U;
+        return BT_GATT_ITER_STOP;
     }
 
+    if (length != sizeof(struct zmk_split_clock_sync_payload)) {
+        LOG_WRN("Ignoring clock sync notify with incorrect data length (%d)", length);
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    struct zmk_split_clock_sync_payload payload;
+    memcpy(&payload, data, sizeof(payload));
+
+    struct peripheral_event_wrapper ev = {
+        .source = peripheral_slot_index_for_conn(conn),
+        .event = {.type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_CLOCK_SYNC_EVENT,
+                  .data = {.clock_sync_event = {
+                               .central_time = payload.central_time,
+                               .peripheral_time = payload.peripheral_time,
+                           }}}};
+
+    k_msgq_put(&peripheral_event_msgq, &ev, K_NO_WAIT);
+    k_work_submit(&peripheral_event_work);
+
     return BT_GATT_ITER_CONTINUE;
 }
 
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
 
 static uint8_t split_central_battery_level_notify_func(struct bt_conn *conn,
@@ -475,15 +579,236 @@ static uint8_t split_central_battery_level_read_func(struct bt_conn *conn, uint8
     return BT_GATT_ITER_CONTINUE;
 }
 
+static int split_central_read_battery_level(struct peripheral_slot *slot, uint16_t handle) {
+    slot->batt_lvl_read_params.func = split_central_battery_level_read_func;
+    slot->batt_lvl_read_params.handle_count = 1;
+    slot->batt_lvl_read_params.single.handle = handle;
+    slot->batt_lvl_read_params.single.offset = 0;
+    return bt_gatt_read(slot->conn, &slot->batt_lvl_read_params);
+}
+
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
+// Bump whenever the meaning of the cached handles changes
+#define HANDLE_CACHE_VERSION 2
+
+#if IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
+
+struct handle_cache_input {
+    uint16_t value_handle;
+    uint16_t ccc_handle;
+    uint8_t reg;
+} __packed;
+
+#endif // IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
+
+// The members follow the enabled features, so a cache stored by a differently configured build
+// fails the size check when loaded and is rebuilt by a full discovery.
+struct handle_cache {
+    uint8_t version;
+    bt_addr_le_t addr;
+    // GATT database hash of the peripheral the handles were discovered on, any change to its
+    // services changes the hash
+    uint8_t db_hash[16];
+    uint16_t position_state;
+    uint16_t position_state_ccc;
+    uint16_t run_behavior;
+    uint16_t selected_physical_layout;
+#if ZMK_KEYMAP_HAS_SENSORS
+    uint16_t sensor_state;
+    uint16_t sensor_state_ccc;
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    uint16_t update_hid_indicators;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    uint16_t clock_sync;
+    uint16_t clock_sync_ccc;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+    uint16_t battery_level;
+    uint16_t battery_level_ccc;
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+#if IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
+    uint8_t input_count;
+    struct handle_cache_input inputs[ARRAY_SIZE(peripheral_input_slots)];
+#endif // IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
+} __packed;
+
+static struct handle_cache handle_caches[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
+static ATOMIC_DEFINE(handle_caches_dirty, ZMK_SPLIT_BLE_PERIPHERAL_COUNT);
+
+static void handle_cache_save_work_cb(struct k_work *work) {
+    for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
+        if (!atomic_test_and_clear_bit(handle_caches_dirty, i)) {
+            continue;
+        }
+
+        char setting_name[32];
+        sprintf(setting_name, "ble_central/handles/%d", i);
+
+        int err;
+        if (handle_caches[i].version == HANDLE_CACHE_VERSION) {
+            err = settings_save_one(setting_name, &handle_caches[i], sizeof(struct handle_cache));
+        } else {
+            err = settings_delete(setting_name);
+        }
+
+        if (err < 0) {
+            LOG_WRN("Failed to store the GATT handle cache for peripheral %d (err %d)", i, err);
+        }
+    }
+}
+
+static K_WORK_DEFINE(handle_cache_save_work, handle_cache_save_work_cb);
+
+static void handle_cache_mark_dirty(int idx) {
+    atomic_set_bit(handle_caches_dirty, idx);
+    k_work_submit(&handle_cache_save_work);
+}
+
+static bool handle_cache_invalidate(int idx) {
+    if (handle_caches[idx].version != HANDLE_CACHE_VERSION) {
+        return false;
+    }
+
+    LOG_DBG("Invalidating the GATT handle cache for peripheral %d", idx);
+    memset(&handle_caches[idx], 0, sizeof(struct handle_cache));
+    handle_cache_mark_dirty(idx);
+
+    return true;
+}
+
+static bool subscription_is_pending(const struct bt_gatt_subscribe_params *params) {
+    return params->value_handle && !params->ccc_handle;
+}
+
+static void handle_cache_update(int idx) {
+    struct peripheral_slot *slot = &peripherals[idx];
+
+    // Only cache a complete set of handles, CCC handles included. Without a database hash there's
+    // no way to tell whether they are still valid on the next connection.
+    if (!slot->discovery_complete || !slot->subscribe_params.ccc_handle || !slot->db_hash_valid) {
+        return;
+    }
+
+    struct handle_cache cache = {
+        .version = HANDLE_CACHE_VERSION,
+        .position_state = slot->subscribe_params.value_handle,
+        .position_state_ccc = slot->subscribe_params.ccc_handle,
+        .run_behavior = slot->run_behavior_handle,
+        .selected_physical_layout = slot->selected_physical_layout_handle,
+    };
+    bt_addr_le_copy(&cache.addr, bt_conn_get_dst(slot->conn));
+    memcpy(cache.db_hash, slot->db_hash, sizeof(cache.db_hash));
+
+#if ZMK_KEYMAP_HAS_SENSORS
+    if (subscription_is_pending(&slot->sensor_subscribe_params)) {
+        return;
+    }
+    cache.sensor_state = slot->sensor_subscribe_params.value_handle;
+    cache.sensor_state_ccc = slot->sensor_subscribe_params.ccc_handle;
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    cache.update_hid_indicators = slot->update_hid_indicators;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    if (subscription_is_pending(&slot->clock_sync_subscribe_params)) {
+        return;
+    }
+    cache.clock_sync = slot->clock_sync_handle;
+    cache.clock_sync_ccc = slot->clock_sync_subscribe_params.ccc_handle;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+    if (subscription_is_pending(&slot->batt_lvl_subscribe_params)) {
+        return;
+    }
+    cache.battery_level = slot->batt_lvl_subscribe_params.value_handle;
+    cache.battery_level_ccc = slot->batt_lvl_subscribe_params.ccc_handle;
 #endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+#if IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
+    for (size_t i = 0; i < ARRAY_SIZE(peripheral_input_slots); i++) {
+        if (peripheral_input_slots[i].conn != slot->conn) {
+            continue;
+        }
+
+        if (input_slot_is_pending(i)) {
+            return;
+        }
+
+        cache.inputs[cache.input_count++] = (struct handle_cache_input){
+            .value_handle = peripheral_input_slots[i].sub.value_handle,
+            .ccc_handle = peripheral_input_slots[i].sub.ccc_handle,
+            .reg = peripheral_input_slots[i].reg,
+        };
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
+
+    if (memcmp(&cache, &handle_caches[idx], sizeof(struct handle_cache)) == 0) {
+        return;
+    }
+
+    LOG_DBG("Caching GATT handles for peripheral %d", idx);
+    handle_caches[idx] = cache;
+    handle_cache_mark_dirty(idx);
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
+static void split_central_subscription_ready(int idx, struct bt_gatt_subscribe_params *params) {
+    struct peripheral_slot *slot = &peripherals[idx];
+
+    if (params == &slot->subscribe_params && slot->stats.time_to_ready < 0) {
+        slot->stats.time_to_ready = k_uptime_get() - slot->connected_at;
+        LOG_DBG("Peripheral %d ready for key events %d ms after connecting", idx,
+                slot->stats.time_to_ready);
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+    handle_cache_update(idx);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+}
+
+static void split_central_subscribed(struct bt_conn *conn, uint8_t err,
+                                     struct bt_gatt_subscribe_params *params) {
+    int idx = peripheral_slot_index_for_conn(conn);
+    if (idx < 0) {
+        return;
+    }
+
+    if (err) {
+        LOG_ERR("Subscribing to handle %d failed (err %d)", params->value_handle, err);
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+        if (peripherals[idx].stats.handles_from_cache && handle_cache_invalidate(idx)) {
+            // The peripheral's GATT database no longer matches the cache, so reconnect and
+            // start over with a full discovery.
+            bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+        }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+        return;
+    }
+
+    split_central_subscription_ready(idx, params);
+}
 
 static int split_central_subscribe(struct bt_conn *conn, struct bt_gatt_subscribe_params *params) {
     atomic_set(params->flags, BT_GATT_SUBSCRIBE_FLAG_NO_RESUB);
+    params->subscribe = split_central_subscribed;
     int err = bt_gatt_subscribe(conn, params);
     switch (err) {
-    case -EALREADY:
+    case -EALREADY: {
         LOG_DBG("[ALREADY SUBSCRIBED]");
+        // Subscriptions to bonded peripherals persist across reconnects, so there's no CCC
+        // write to wait for.
+        int idx = peripheral_slot_index_for_conn(conn);
+        if (idx >= 0) {
+            split_central_subscription_ready(idx, params);
+        }
         break;
+    }
     case 0:
         LOG_DBG("[SUBSCRIBED]");
         break;
@@ -495,6 +820,23 @@ static int split_central_subscribe(struct bt_conn *conn, struct bt_gatt_subscrib
     return err;
 }
 
+// Each subscription carries its own discover params for finding a missing CCC handle, so any
+// number of them can be in flight at once instead of being chained one after the other.
+static int split_central_subscribe_chrc(struct bt_conn *conn,
+                                        struct bt_gatt_subscribe_params *params,
+                                        struct bt_gatt_discover_params *disc_params,
+                                        uint16_t end_handle, uint16_t value_handle,
+                                        uint16_t ccc_handle, bt_gatt_notify_func_t notify) {
+    params->disc_params = disc_params;
+    params->end_handle = end_handle;
+    params->value_handle = value_handle;
+    params->ccc_handle = ccc_handle;
+    params->notify = notify;
+    params->value = BT_GATT_CCC_NOTIFY;
+
+    return split_central_subscribe(conn, params);
+}
+
 static int update_peripheral_selected_layout(struct peripheral_slot *slot, uint8_t layout_idx) {
     if (slot->state != PERIPHERAL_SLOT_STATE_CONNECTED) {
         return -ENOTCONN;
@@ -535,11 +877,24 @@ static void update_peripherals_selected_physical_layout(struct k_work *_work) {
 K_WORK_DEFINE(update_peripherals_selected_layouts_work,
               update_peripherals_selected_physical_layout);
 
+static void split_central_discovery_completed(struct bt_conn *conn) {
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+    int idx = peripheral_slot_index_for_conn(conn);
+    if (idx < 0) {
+        return;
+    }
+
+    peripherals[idx].discovery_complete = true;
+    handle_cache_update(idx);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+}
+
 static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
                                                  const struct bt_gatt_attr *attr,
                                                  struct bt_gatt_discover_params *params) {
     if (!attr) {
         LOG_DBG("Discover complete");
+        split_central_discovery_completed(conn);
         return BT_GATT_ITER_STOP;
     }
 
@@ -562,12 +917,10 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
         if (bt_uuid_cmp(chrc_uuid, BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_POSITION_STATE_UUID)) ==
             0) {
             LOG_DBG("Found position state characteristic");
-            slot->subscribe_params.disc_params = &slot->sub_discover_params;
-            slot->subscribe_params.end_handle = slot->discover_params.end_handle;
-            slot->subscribe_params.value_handle = bt_gatt_attr_value_handle(attr);
-            slot->subscribe_params.notify = split_central_notify_func;
-            slot->subscribe_params.value = BT_GATT_CCC_NOTIFY;
-            split_central_subscribe(conn, &slot->subscribe_params);
+            split_central_subscribe_chrc(conn, &slot->subscribe_params, &slot->sub_discover_params,
+                                         slot->discover_params.end_handle,
+                                         bt_gatt_attr_value_handle(attr), 0,
+                                         split_central_notify_func);
 #if ZMK_KEYMAP_HAS_SENSORS
         } else if (bt_uuid_cmp(chrc_uuid,
                                BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CHAR_SENSOR_STATE_UUID)) == 0) {
@@ -575,12 +928,11 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
             slot->discover_params.start_handle = attr->handle + 2;
             slot->discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
 
-            slot->sensor_subscribe_params.disc_params = &slot->sub_discover_params;
-            slot->sensor_subscribe_params.end_handle = slot->discover_params.end_handle;
-            slot->sensor_subscribe_params.value_handle = bt_gatt_attr_value_handle(attr);
-            slot->sensor_subscribe_params.notify = split_central_sensor_notify_func;
-            slot->sensor_subscribe_params.value = BT_GATT_CCC_NOTIFY;
-            split_central_subscribe(conn, &slot->sensor_subscribe_params);
+            split_central_subscribe_chrc(conn, &slot->sensor_subscribe_params,
+                                         &slot->sensor_sub_discover_params,
+                                         slot->discover_params.end_handle,
+                                         bt_gatt_attr_value_handle(attr), 0,
+                                         split_central_sensor_notify_func);
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
 #if IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
         } else if (bt_uuid_cmp(chrc_uuid, BT_UUID_DECLARE_128(ZMK_SPLIT_BT_INPUT_EVENT_UUID)) ==
@@ -620,22 +972,26 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
             LOG_DBG("Found update HID indicators handle");
             slot->update_hid_indicators = bt_gatt_attr_value_handle(attr);
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+        } else if (!bt_uuid_cmp(((struct bt_gatt_chrc *)attr->user_data)->uuid,
+                                BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CLOCK_SYNC_UUID))) {
+            LOG_DBG("Found clock sync handle");
+            slot->clock_sync_handle = bt_gatt_attr_value_handle(attr);
+            split_central_subscribe_chrc(conn, &slot->clock_sync_subscribe_params,
+                                         &slot->clock_sync_sub_discover_params,
+                                         slot->discover_params.end_handle, slot->clock_sync_handle,
+                                         0, split_central_clock_sync_notify_func);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
         } else if (!bt_uuid_cmp(((struct bt_gatt_chrc *)attr->user_data)->uuid,
                                 BT_UUID_BAS_BATTERY_LEVEL)) {
             LOG_DBG("Found battery level characteristics");
-            slot->batt_lvl_subscribe_params.disc_params = &slot->sub_discover_params;
-            slot->batt_lvl_subscribe_params.end_handle = slot->discover_params.end_handle;
-            slot->batt_lvl_subscribe_params.value_handle = bt_gatt_attr_value_handle(attr);
-            slot->batt_lvl_subscribe_params.notify = split_central_battery_level_notify_func;
-            slot->batt_lvl_subscribe_params.value = BT_GATT_CCC_NOTIFY;
-            split_central_subscribe(conn, &slot->batt_lvl_subscribe_params);
-
-            slot->batt_lvl_read_params.func = split_central_battery_level_read_func;
-            slot->batt_lvl_read_params.handle_count = 1;
-            slot->batt_lvl_read_params.single.handle = bt_gatt_attr_value_handle(attr);
-            slot->batt_lvl_read_params.single.offset = 0;
-            bt_gatt_read(conn, &slot->batt_lvl_read_params);
+            split_central_subscribe_chrc(conn, &slot->batt_lvl_subscribe_params,
+                                         &slot->batt_lvl_sub_discover_params,
+                                         slot->discover_params.end_handle,
+                                         bt_gatt_attr_value_handle(attr), 0,
+                                         split_central_battery_level_notify_func);
+            split_central_read_battery_level(slot, bt_gatt_attr_value_handle(attr));
 #endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
         }
         break;
@@ -698,6 +1054,11 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
     subscribed = subscribed && slot->batt_lvl_subscribe_params.value_handle;
 #endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    // Older peripherals lack the characteristic, in which case discovery runs to the end of the
+    // service instead.
+    subscribed = subscribed && slot->clock_sync_handle;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
 #if IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
     for (size_t i = 0; i < ARRAY_SIZE(peripheral_input_slots); i++) {
         if (input_slot_is_open(i) || input_slot_is_pending(i)) {
@@ -707,7 +1068,12 @@ static uint8_t split_central_chrc_discovery_func(struct bt_conn *conn,
     }
 #endif // IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
 
-    return subscribed ? BT_GATT_ITER_STOP : BT_GATT_ITER_CONTINUE;
+    if (subscribed) {
+        split_central_discovery_completed(conn);
+        return BT_GATT_ITER_STOP;
+    }
+
+    return BT_GATT_ITER_CONTINUE;
 }
 
 static uint8_t split_central_service_discovery_func(struct bt_conn *conn,
@@ -745,9 +1111,150 @@ static uint8_t split_central_service_discovery_func(struct bt_conn *conn,
     return BT_GATT_ITER_STOP;
 }
 
-static void split_central_process_connection(struct bt_conn *conn) {
-    int err;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
+static bool handle_cache_restore(int idx) {
+    struct peripheral_slot *slot = &peripherals[idx];
+    const struct handle_cache *cache = &handle_caches[idx];
+
+    if (cache->version != HANDLE_CACHE_VERSION ||
+        bt_addr_le_cmp(&cache->addr, bt_conn_get_dst(slot->conn)) != 0) {
+        return false;
+    }
+
+    if (!slot->db_hash_valid || memcmp(cache->db_hash, slot->db_hash, sizeof(slot->db_hash)) != 0) {
+        LOG_DBG("GATT database of peripheral %d changed, not using the cached handles", idx);
+        return false;
+    }
+
+    LOG_DBG("Restoring cached GATT handles for peripheral %d", idx);
+
+    slot->stats.handles_from_cache = true;
+    slot->discovery_complete = true;
+    slot->run_behavior_handle = cache->run_behavior;
+    slot->selected_physical_layout_handle = cache->selected_physical_layout;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+    slot->update_hid_indicators = cache->update_hid_indicators;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+
+    // With every handle known up front, the subscriptions don't depend on each other and are all
+    // issued right away.
+    split_central_subscribe_chrc(slot->conn, &slot->subscribe_params, &slot->sub_discover_params,
+                                 0xffff, cache->position_state, cache->position_state_ccc,
+                                 split_central_notify_func);
+#if ZMK_KEYMAP_HAS_SENSORS
+    if (cache->sensor_state) {
+        split_central_subscribe_chrc(slot->conn, &slot->sensor_subscribe_params,
+                                     &slot->sensor_sub_discover_params, 0xffff,
+                                     cache->sensor_state, cache->sensor_state_ccc,
+                                     split_central_sensor_notify_func);
+    }
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    slot->clock_sync_handle = cache->clock_sync;
+    if (cache->clock_sync) {
+        split_central_subscribe_chrc(slot->conn, &slot->clock_sync_subscribe_params,
+                                     &slot->clock_sync_sub_discover_params, 0xffff,
+                                     cache->clock_sync, cache->clock_sync_ccc,
+                                     split_central_clock_sync_notify_func);
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+    if (cache->battery_level) {
+        split_central_subscribe_chrc(slot->conn, &slot->batt_lvl_subscribe_params,
+                                     &slot->batt_lvl_sub_discover_params, 0xffff,
+                                     cache->battery_level, cache->battery_level_ccc,
+                                     split_central_battery_level_notify_func);
+        split_central_read_battery_level(slot, cache->battery_level);
+    }
+#endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING) */
+#if IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
+    for (size_t i = 0; i < cache->input_count; i++) {
+        struct peripheral_input_slot *input_slot;
+        int ret = reserve_next_open_input_slot(&input_slot, slot->conn);
+        if (ret < 0) {
+            LOG_WRN("No available slot for peripheral input subscriptions (%d)", ret);
+            break;
+        }
+
+        input_slot->reg = cache->inputs[i].reg;
+        split_central_subscribe_chrc(slot->conn, &input_slot->sub, NULL, 0xffff,
+                                     cache->inputs[i].value_handle, cache->inputs[i].ccc_handle,
+                                     peripheral_input_event_notify_cb);
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
+
+    k_work_submit(&update_peripherals_selected_layouts_work);
+
+    return true;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
+static void split_central_discover_service(struct peripheral_slot *slot) {
+    slot->discover_params.uuid = &split_service_uuid.uuid;
+    slot->discover_params.func = split_central_service_discovery_func;
+    slot->discover_params.start_handle = 0x0001;
+    slot->discover_params.end_handle = 0xffff;
+    slot->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
+
+    int err = bt_gatt_discover(slot->conn, &slot->discover_params);
+    if (err) {
+        LOG_ERR("Discover failed(err %d)", err);
+    }
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
+static uint8_t split_central_db_hash_read_func(struct bt_conn *conn, uint8_t err,
+                                               struct bt_gatt_read_params *params,
+                                               const void *data, uint16_t length) {
+    int idx = peripheral_slot_index_for_conn(conn);
+    if (idx < 0) {
+        return BT_GATT_ITER_STOP;
+    }
+
+    struct peripheral_slot *slot = &peripherals[idx];
+
+    if (!err && data && length == sizeof(slot->db_hash)) {
+        memcpy(slot->db_hash, data, length);
+        slot->db_hash_valid = true;
+    } else {
+        LOG_DBG("No GATT database hash from peripheral %d (err %d), handles won't be cached", idx,
+                err);
+    }
+
+    if (!handle_cache_restore(idx)) {
+        split_central_discover_service(slot);
+    }
+
+    return BT_GATT_ITER_STOP;
+}
 
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
+static void split_central_start_discovery(struct peripheral_slot *slot) {
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+    // The cached handles are only trusted if the peripheral's GATT database hash still matches,
+    // reading it first costs a single round trip compared to the full discovery.
+    slot->db_hash_read_params = (struct bt_gatt_read_params){
+        .func = split_central_db_hash_read_func,
+        .handle_count = 0,
+        .by_uuid = {.uuid = BT_UUID_GATT_DB_HASH, .start_handle = 0x0001, .end_handle = 0xffff},
+    };
+
+    int err = bt_gatt_read(slot->conn, &slot->db_hash_read_params);
+    if (err == 0) {
+        return;
+    }
+
+    LOG_WRN("Failed to read the GATT database hash (err %d)", err);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
+    split_central_discover_service(slot);
+}
+
+static void split_central_process_connection(struct bt_conn *conn) {
     LOG_DBG("Current security for connection: %d", bt_conn_get_security(conn));
 
     struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
@@ -757,17 +1264,7 @@ static void split_central_process_connection(struct bt_conn *conn) {
     }
 
     if (!slot->subscribe_params.value_handle) {
-        slot->discover_params.uuid = &split_service_uuid.uuid;
-        slot->discover_params.func = split_central_service_discovery_func;
-        slot->discover_params.start_handle = 0x0001;
-        slot->discover_params.end_handle = 0xffff;
-        slot->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
-
-        err = bt_gatt_discover(slot->conn, &slot->discover_params);
-        if (err) {
-            LOG_ERR("Discover failed(err %d)", err);
-            return;
-        }
+        split_central_start_discovery(slot);
     }
 
     struct bt_conn_info info;
@@ -943,6 +1440,16 @@ static void split_central_connected(struct bt_conn *conn, uint8_t conn_err) {
 
     LOG_DBG("Connected: %s", addr);
 
+    struct peripheral_slot *slot = peripheral_slot_for_conn(conn);
+    if (slot) {
+        slot->connected_at = k_uptime_get();
+        slot->stats = (struct zmk_split_bt_central_connection_stats){
+            .handles_from_cache = false,
+            .time_to_ready = -1,
+            .time_to_first_key = -1,
+        };
+    }
+
     confirm_peripheral_slot_conn(conn);
     split_central_process_connection(conn);
     k_work_submit(&notify_status_work);
@@ -1097,6 +1604,27 @@ void split_central_split_run_callback(struct k_work *work) {
             }
             break;
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+        case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SYNC_CLOCK: {
+            if (peripherals[payload_wrapper.source].clock_sync_handle == 0) {
+                // Peripherals running older firmware don't expose the clock sync characteristic
+                break;
+            }
+
+            uint8_t central_time[sizeof(uint32_t)];
+            sys_put_le32(payload_wrapper.cmd.data.sync_clock.central_time, central_time);
+
+            int err = bt_gatt_write_without_response(
+                peripherals[payload_wrapper.source].conn,
+                peripherals[payload_wrapper.source].clock_sync_handle, central_time,
+                sizeof(central_time), true);
+
+            if (err) {
+                LOG_ERR("Failed to write clock sync characteristic (err %d)", err);
+            }
+            break;
+        }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
         default:
             LOG_WRN("Unsupported wrapped central command type %d", payload_wrapper.cmd.type);
             return;
@@ -1137,6 +1665,39 @@ static bool settings_loaded = false;
 
 static int central_ble_handle_set(const char *name, size_t len, settings_read_cb read_cb,
                                   void *cb_arg) {
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+    const char *next;
+
+    if (settings_name_steq(name, "handles", &next) && next) {
+        char *endptr;
+        uint8_t idx = strtoul(next, &endptr, 10);
+        if (*endptr != '\0') {
+            LOG_WRN("Invalid handle cache index: %s", next);
+            return -EINVAL;
+        }
+
+        if (idx >= ZMK_SPLIT_BLE_PERIPHERAL_COUNT) {
+            LOG_WRN("Handle cache index %d is larger than max of %d", idx,
+                    ZMK_SPLIT_BLE_PERIPHERAL_COUNT);
+            return -EINVAL;
+        }
+
+        if (len != sizeof(struct handle_cache)) {
+            // Stored by a build with different features, so rediscover on the next connection
+            LOG_DBG("Ignoring handle cache with mismatched size (got %d expected %d)", len,
+                    sizeof(struct handle_cache));
+            return 0;
+        }
+
+        int err = read_cb(cb_arg, &handle_caches[idx], sizeof(struct handle_cache));
+        if (err <= 0) {
+            LOG_ERR("Failed to handle cached GATT handles from settings (err %d)", err);
+            memset(&handle_caches[idx], 0, sizeof(struct handle_cache));
+            return err;
+        }
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_HANDLE_CACHE)
+
     return 0;
 }
 
@@ -1178,6 +1739,7 @@ static int split_central_bt_send_command(uint8_t source,
     }
 
     switch (cmd.type) {
+    case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SYNC_CLOCK:
     case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SET_HID_INDICATORS:
     case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SET_PHYSICAL_LAYOUT:
     case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_INVOKE_BEHAVIOR: {
@@ -1193,6 +1755,21 @@ static int split_central_bt_send_command(uint8_t source,
     return 0;
 }
 
+int zmk_split_bt_central_get_connection_stats(uint8_t source,
+                                              struct zmk_split_bt_central_connection_stats *stats) {
+    if (source >= ARRAY_SIZE(peripherals)) {
+        return -EINVAL;
+    }
+
+    if (peripherals[source].state != PERIPHERAL_SLOT_STATE_CONNECTED) {
+        return -ENOTCONN;
+    }
+
+    *stats = peripherals[source].stats;
+
+    return 0;
+}
+
 static int split_central_bt_get_available_source_ids(uint8_t *sources) {
     int count = 0;
     for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
@@ -1287,6 +1864,10 @@ static int finish_init() {
 
 void peripheral_event_work_callback(struct k_work *work) {
     struct peripheral_event_wrapper ev;
+
+    zmk_telemetry_record_queue_depth(ZMK_TELEMETRY_QUEUE_SPLIT,
+                                     k_msgq_num_used_get(&peripheral_event_msgq));
+
     while (k_msgq_get(&peripheral_event_msgq, &ev, K_NO_WAIT) == 0) {
         LOG_DBG("Trigger key position state change for %d",
                 ev.event.data.key_position_event.position);
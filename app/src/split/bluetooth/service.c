@@ -14,9 +14,14 @@
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+#include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/uuid.h>
 
+#if IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
+#include <zephyr/input/input.h>
+#endif
+
 #include <drivers/behavior.h>
 #include <zmk/stdlib.h>
 #include <zmk/behavior.h>
@@ -49,9 +54,30 @@ static void split_svc_sensor_state_ccc(const struct bt_gatt_attr *attr, uint16_t
 }
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
 
-#define POS_STATE_LEN 16
+// Notifying the whole state of a larger peripheral would outgrow the default ATT MTU, so only
+// the segment holding the changed position is sent instead.
+#define POS_STATE_SEGMENTED (ZMK_KEYMAP_LEN > ZMK_SPLIT_POS_STATE_LEGACY_LEN * 8)
+#define POS_STATE_LEN                                                                              \
+    (POS_STATE_SEGMENTED                                                                           \
+         ? ROUND_UP(DIV_ROUND_UP(ZMK_KEYMAP_LEN, 8), ZMK_SPLIT_POS_STATE_SEGMENT_LEN)              \
+         : ZMK_SPLIT_POS_STATE_LEGACY_LEN)
+
+struct position_state_legacy_notification {
+    uint8_t state[ZMK_SPLIT_POS_STATE_LEGACY_LEN];
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    // Uptime of the peripheral when this state was captured
+    uint32_t timestamp;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+} __packed;
+
+union position_state_notification {
+    struct position_state_legacy_notification legacy;
+    struct zmk_split_position_state_segment segment;
+};
+
+BUILD_ASSERT(ZMK_KEYMAP_LEN <= UINT16_MAX, "Too many key positions for the split position state");
 
-static uint8_t num_of_positions = ZMK_KEYMAP_LEN;
+static uint8_t num_of_positions = MIN(ZMK_KEYMAP_LEN, UINT8_MAX);
 static uint8_t position_state[POS_STATE_LEN];
 
 static struct zmk_split_run_behavior_payload behavior_run_payload;
@@ -139,6 +165,35 @@ static ssize_t split_svc_get_selected_phys_layout(struct bt_conn *conn,
     return bt_gatt_attr_read(conn, attrs, buf, len, offset, &selected, sizeof(selected));
 }
 
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+
+static ssize_t split_svc_clock_sync(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                                    const void *buf, uint16_t len, uint16_t offset,
+                                    uint8_t flags) {
+    if (offset != 0 || len != sizeof(uint32_t)) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+
+    struct zmk_split_transport_central_command cmd = {
+        .type = ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SYNC_CLOCK,
+        .data = {.sync_clock = {.central_time = sys_get_le32(buf)}},
+    };
+
+    int err =
+        zmk_split_transport_peripheral_command_handler(zmk_split_transport_peripheral_bt(), cmd);
+    if (err < 0) {
+        LOG_WRN("Failed to handle clock sync request (%d)", err);
+    }
+
+    return len;
+}
+
+static void split_svc_clock_sync_ccc(const struct bt_gatt_attr *attr, uint16_t value) {
+    LOG_DBG("value %d", value);
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+
 #if IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
 
 static void split_input_events_ccc(const struct bt_gatt_attr *attr, uint16_t value) {
@@ -205,37 +260,125 @@ BT_GATT_SERVICE_DEFINE(
                            BT_GATT_CHRC_WRITE | BT_GATT_CHRC_READ,
                            BT_GATT_PERM_WRITE_ENCRYPT | BT_GATT_PERM_READ_ENCRYPT,
                            split_svc_get_selected_phys_layout, split_svc_select_phys_layout,
-                           NULL), );
+                           NULL),
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CLOCK_SYNC_UUID),
+                           BT_GATT_CHRC_WRITE_WITHOUT_RESP | BT_GATT_CHRC_NOTIFY,
+                           BT_GATT_PERM_WRITE_ENCRYPT, NULL, split_svc_clock_sync, NULL),
+    BT_GATT_CCC(split_svc_clock_sync_ccc, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+);
 
 K_THREAD_STACK_DEFINE(service_q_stack, CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_STACK_SIZE);
 
 struct k_work_q service_work_q;
 
-K_MSGQ_DEFINE(position_state_msgq, sizeof(char[POS_STATE_LEN]),
+K_MSGQ_DEFINE(position_state_msgq, sizeof(union position_state_notification),
               CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_QUEUE_SIZE, 4);
 
+#define POS_STATE_SEGMENTS                                                                         \
+    (POS_STATE_SEGMENTED ? POS_STATE_LEN / ZMK_SPLIT_POS_STATE_SEGMENT_LEN : 1)
+
+// Delay before notifying stale segments again after running out of buffers
+#define POS_STATE_RETRY_MS 10
+
+// Segments whose latest state may not have reached the central, because their queued message was
+// coalesced on overflow or failed to notify. Their current state is sent once the queue drains.
+static ATOMIC_DEFINE(stale_pos_state_segments, POS_STATE_SEGMENTS);
+static uint32_t pos_state_segment_timestamps[POS_STATE_SEGMENTS];
+
+static uint16_t position_state_segment(const union position_state_notification *state) {
+    return POS_STATE_SEGMENTED
+               ? sys_le16_to_cpu(state->segment.offset) / ZMK_SPLIT_POS_STATE_SEGMENT_LEN
+               : 0;
+}
+
+static void build_position_state(union position_state_notification *state, uint16_t segment) {
+    *state = (union position_state_notification){0};
+
+    if (POS_STATE_SEGMENTED) {
+        uint16_t offset = segment * ZMK_SPLIT_POS_STATE_SEGMENT_LEN;
+
+        state->segment.offset = sys_cpu_to_le16(offset);
+        memcpy(state->segment.state, &position_state[offset], sizeof(state->segment.state));
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+        state->segment.timestamp = sys_cpu_to_le32(pos_state_segment_timestamps[segment]);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    } else {
+        memcpy(state->legacy.state, position_state, sizeof(state->legacy.state));
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+        state->legacy.timestamp = sys_cpu_to_le32(pos_state_segment_timestamps[segment]);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    }
+}
+
+static bool notify_position_state(const union position_state_notification *state) {
+    const uint16_t len = POS_STATE_SEGMENTED ? sizeof(state->segment) : sizeof(state->legacy);
+
+    int err = bt_gatt_notify(NULL, &split_svc.attrs[1], state, len);
+    if (err == -ENOTCONN) {
+        // Nobody is subscribed, the central starts over from a clean state when it reconnects
+        return true;
+    } else if (err) {
+        LOG_DBG("Error notifying %d", err);
+        return false;
+    }
+
+    return true;
+}
+
+void send_position_state_callback(struct k_work *work);
+
+K_WORK_DEFINE(service_position_notify_work, send_position_state_callback);
+static K_WORK_DELAYABLE_DEFINE(service_position_retry_work, send_position_state_callback);
+
 void send_position_state_callback(struct k_work *work) {
-    uint8_t state[POS_STATE_LEN];
+    union position_state_notification state;
 
     while (k_msgq_get(&position_state_msgq, &state, K_NO_WAIT) == 0) {
-        int err = bt_gatt_notify(NULL, &split_svc.attrs[1], &state, sizeof(state));
-        if (err) {
-            LOG_DBG("Error notifying %d", err);
+        if (!notify_position_state(&state)) {
+            atomic_set_bit(stale_pos_state_segments, position_state_segment(&state));
         }
     }
+
+    bool retry = false;
+
+    for (uint16_t i = 0; i < POS_STATE_SEGMENTS; i++) {
+        if (!atomic_test_and_clear_bit(stale_pos_state_segments, i)) {
+            continue;
+        }
+
+        build_position_state(&state, i);
+        if (!notify_position_state(&state)) {
+            atomic_set_bit(stale_pos_state_segments, i);
+            retry = true;
+        }
+    }
+
+    if (retry) {
+        k_work_schedule_for_queue(&service_work_q, &service_position_retry_work,
+                                  K_MSEC(POS_STATE_RETRY_MS));
+    }
 };
 
-K_WORK_DEFINE(service_position_notify_work, send_position_state_callback);
+int send_position_state(uint16_t position, uint32_t timestamp) {
+    union position_state_notification state;
+    uint16_t segment = POS_STATE_SEGMENTED ? position / 8 / ZMK_SPLIT_POS_STATE_SEGMENT_LEN : 0;
+
+    pos_state_segment_timestamps[segment] = timestamp;
+    build_position_state(&state, segment);
 
-int send_position_state() {
-    int err = k_msgq_put(&position_state_msgq, position_state, K_MSEC(100));
+    int err = k_msgq_put(&position_state_msgq, &state, K_MSEC(100));
     if (err) {
         switch (err) {
         case -EAGAIN: {
-            LOG_WRN("Position state message queue full, popping first message and queueing again");
-            uint8_t discarded_state[POS_STATE_LEN];
-            k_msgq_get(&position_state_msgq, &discarded_state, K_NO_WAIT);
-            return send_position_state();
+            // The oldest message gets coalesced into a resend of its segment's current state
+            LOG_WRN("Position state message queue full, coalescing first message");
+            union position_state_notification coalesced_state;
+            if (k_msgq_get(&position_state_msgq, &coalesced_state, K_NO_WAIT) == 0) {
+                atomic_set_bit(stale_pos_state_segments, position_state_segment(&coalesced_state));
+            }
+            return send_position_state(position, timestamp);
         }
         default:
             LOG_WRN("Failed to queue position state to send (%d)", err);
@@ -248,16 +391,64 @@ int send_position_state() {
     return 0;
 }
 
-static int zmk_split_bt_position_pressed(uint8_t position) {
+static int zmk_split_bt_position_pressed(uint16_t position, uint32_t timestamp) {
+    if (position >= POS_STATE_LEN * 8) {
+        return -EINVAL;
+    }
+
     WRITE_BIT(position_state[position / 8], position % 8, true);
-    return send_position_state();
+    return send_position_state(position, timestamp);
 }
 
-static int zmk_split_bt_position_released(uint8_t position) {
+static int zmk_split_bt_position_released(uint16_t position, uint32_t timestamp) {
+    if (position >= POS_STATE_LEN * 8) {
+        return -EINVAL;
+    }
+
     WRITE_BIT(position_state[position / 8], position % 8, false);
-    return send_position_state();
+    return send_position_state(position, timestamp);
 }
 
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+
+K_MSGQ_DEFINE(clock_sync_msgq, sizeof(struct zmk_split_clock_sync_payload), 2, 4);
+
+static void send_clock_sync_callback(struct k_work *work) {
+    struct zmk_split_clock_sync_payload payload;
+
+    const struct bt_gatt_attr *attr =
+        bt_gatt_find_by_uuid(split_svc.attrs, split_svc.attr_count,
+                             BT_UUID_DECLARE_128(ZMK_SPLIT_BT_CLOCK_SYNC_UUID));
+
+    while (k_msgq_get(&clock_sync_msgq, &payload, K_NO_WAIT) == 0) {
+        int err = bt_gatt_notify(NULL, attr, &payload, sizeof(payload));
+        if (err) {
+            LOG_DBG("Error notifying %d", err);
+        }
+    }
+}
+
+K_WORK_DEFINE(service_clock_sync_notify_work, send_clock_sync_callback);
+
+static int zmk_split_bt_clock_sync(uint32_t central_time, uint32_t peripheral_time) {
+    struct zmk_split_clock_sync_payload payload = {
+        .central_time = central_time,
+        .peripheral_time = peripheral_time,
+    };
+
+    // A stale sync response is worthless, so drop it rather than retrying
+    int err = k_msgq_put(&clock_sync_msgq, &payload, K_NO_WAIT);
+    if (err) {
+        LOG_DBG("Failed to queue clock sync response (%d)", err);
+        return err;
+    }
+
+    k_work_submit_to_queue(&service_work_q, &service_clock_sync_notify_work);
+    return 0;
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+
 #if ZMK_KEYMAP_HAS_SENSORS
 K_MSGQ_DEFINE(sensor_state_msgq, sizeof(struct sensor_event),
               CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_POSITION_QUEUE_SIZE, 4);
@@ -312,26 +503,201 @@ static int zmk_split_bt_sensor_triggered(uint8_t sensor_index,
 
 #if IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
 
-static int zmk_split_bt_report_input(uint8_t reg, uint8_t type, uint16_t code, int32_t value,
-                                     bool sync) {
-
+static const struct bt_gatt_attr *find_input_attr(uint8_t reg) {
     for (size_t i = 0; i < split_svc.attr_count; i++) {
         if (bt_uuid_cmp(split_svc.attrs[i].uuid,
                         BT_UUID_DECLARE_128(ZMK_SPLIT_BT_INPUT_EVENT_UUID)) == 0 &&
             (uint8_t)(uint32_t)split_svc.attrs[i + 2].user_data == reg) {
-            struct zmk_split_input_event_payload payload = {
-                .type = type,
-                .code = code,
-                .value = value,
-                .sync = sync ? 1 : 0,
-            };
-
-            return bt_gatt_notify(NULL, &split_svc.attrs[i], &payload, sizeof(payload));
+            return &split_svc.attrs[i];
+        }
+    }
+
+    return NULL;
+}
+
+static int notify_input(const struct bt_gatt_attr *attr, uint8_t type, uint16_t code,
+                        int32_t value, bool sync) {
+    struct zmk_split_input_event_payload payload = {
+        .type = type,
+        .code = code,
+        .value = value,
+        .sync = sync ? 1 : 0,
+    };
+
+    return bt_gatt_notify(NULL, attr, &payload, sizeof(payload));
+}
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_INPUT_COALESCING)
+
+// Covers every relative axis code defined by Zephyr
+#define INPUT_ACCUMULATOR_CODES 16
+
+struct input_accumulator {
+    uint8_t reg;
+    const struct bt_gatt_attr *attr;
+    struct k_spinlock lock;
+    int32_t values[INPUT_ACCUMULATOR_CODES];
+    uint16_t dirty;
+    bool synced;
+    int64_t last_flush;
+    struct k_work_delayable flush_work;
+};
+
+#define INPUT_ACCUMULATOR(node_id) {.reg = DT_REG_ADDR(node_id)},
+
+static struct input_accumulator input_accumulators[] = {
+    DT_FOREACH_STATUS_OKAY(zmk_input_split, INPUT_ACCUMULATOR)};
+
+// Used until connected, matches the default split central connection interval (7.5ms)
+#define INPUT_ACCUMULATOR_DEFAULT_INTERVAL 6
+
+// Current connection interval, in ticks
+static atomic_t input_flush_interval = ATOMIC_INIT(0);
+
+static void input_accumulator_update_interval(uint16_t interval) {
+    atomic_set(&input_flush_interval, (atomic_val_t)k_us_to_ticks_floor32(interval * 1250));
+}
+
+static void input_accumulator_flush(struct input_accumulator *acc, bool force) {
+    int32_t values[INPUT_ACCUMULATOR_CODES];
+    uint16_t dirty;
+    bool synced;
+
+    k_spinlock_key_t key = k_spin_lock(&acc->lock);
+    if (!acc->dirty || (!acc->synced && !force)) {
+        k_spin_unlock(&acc->lock, key);
+        return;
+    }
+
+    dirty = acc->dirty;
+    synced = acc->synced;
+    memcpy(values, acc->values, sizeof(values));
+    memset(acc->values, 0, sizeof(acc->values));
+    acc->dirty = 0;
+    acc->synced = false;
+    acc->last_flush = k_uptime_ticks();
+    k_spin_unlock(&acc->lock, key);
+
+    while (dirty) {
+        uint8_t code = __builtin_ctz(dirty);
+        dirty &= ~BIT(code);
+
+        // Only the last merged event closes the frame, so the central applies them together
+        int err = notify_input(acc->attr, INPUT_EV_REL, code, values[code], synced && !dirty);
+        if (err) {
+            LOG_DBG("Error notifying %d", err);
+        }
+    }
+}
+
+static void input_accumulator_flush_work(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct input_accumulator *acc = CONTAINER_OF(dwork, struct input_accumulator, flush_work);
+
+    input_accumulator_flush(acc, false);
+}
+
+static int32_t saturating_add(int32_t a, int32_t b) {
+    int32_t sum;
+    if (__builtin_add_overflow(a, b, &sum)) {
+        return b > 0 ? INT32_MAX : INT32_MIN;
+    }
+
+    return sum;
+}
+
+static int zmk_split_bt_report_input(uint8_t reg, uint8_t type, uint16_t code, int32_t value,
+                                     bool sync) {
+    struct input_accumulator *acc = NULL;
+    for (size_t i = 0; i < ARRAY_SIZE(input_accumulators); i++) {
+        if (input_accumulators[i].reg == reg) {
+            acc = &input_accumulators[i];
+            break;
         }
     }
-    return -ENODEV;
+
+    if (!acc || !acc->attr) {
+        return -ENODEV;
+    }
+
+    if (type != INPUT_EV_REL || code >= INPUT_ACCUMULATOR_CODES) {
+        // Anything else (e.g. buttons) must not overtake motion that happened before it
+        input_accumulator_flush(acc, true);
+        return notify_input(acc->attr, type, code, value, sync);
+    }
+
+    int64_t now = k_uptime_ticks();
+    int64_t elapsed;
+    bool synced;
+
+    k_spinlock_key_t key = k_spin_lock(&acc->lock);
+    acc->values[code] = saturating_add(acc->values[code], value);
+    acc->dirty |= BIT(code);
+    acc->synced |= sync;
+    synced = acc->synced;
+    elapsed = now - acc->last_flush;
+    k_spin_unlock(&acc->lock, key);
+
+    if (!synced) {
+        return 0;
+    }
+
+    int64_t interval = atomic_get(&input_flush_interval);
+    if (elapsed >= interval) {
+        input_accumulator_flush(acc, false);
+    } else {
+        // Keeps the earlier deadline if a flush is already scheduled
+        k_work_schedule_for_queue(&service_work_q, &acc->flush_work, K_TICKS(interval - elapsed));
+    }
+
+    return 0;
 }
 
+static void input_coalescing_connected(struct bt_conn *conn, uint8_t err) {
+    struct bt_conn_info info;
+
+    if (err || bt_conn_get_info(conn, &info) < 0) {
+        return;
+    }
+
+    input_accumulator_update_interval(info.le.interval);
+}
+
+static void input_coalescing_le_param_updated(struct bt_conn *conn, uint16_t interval,
+                                              uint16_t latency, uint16_t timeout) {
+    input_accumulator_update_interval(interval);
+}
+
+static struct bt_conn_cb input_coalescing_conn_callbacks = {
+    .connected = input_coalescing_connected,
+    .le_param_updated = input_coalescing_le_param_updated,
+};
+
+static void input_coalescing_init(void) {
+    input_accumulator_update_interval(INPUT_ACCUMULATOR_DEFAULT_INTERVAL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(input_accumulators); i++) {
+        input_accumulators[i].attr = find_input_attr(input_accumulators[i].reg);
+        k_work_init_delayable(&input_accumulators[i].flush_work, input_accumulator_flush_work);
+    }
+
+    bt_conn_cb_register(&input_coalescing_conn_callbacks);
+}
+
+#else
+
+static int zmk_split_bt_report_input(uint8_t reg, uint8_t type, uint16_t code, int32_t value,
+                                     bool sync) {
+    const struct bt_gatt_attr *attr = find_input_attr(reg);
+    if (!attr) {
+        return -ENODEV;
+    }
+
+    return notify_input(attr, type, code, value, sync);
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_INPUT_COALESCING)
+
 #endif /* IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT) */
 
 static int service_init(void) {
@@ -340,6 +706,10 @@ static int service_init(void) {
     k_work_queue_start(&service_work_q, service_q_stack, K_THREAD_STACK_SIZEOF(service_q_stack),
                        CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_PRIORITY, &queue_config);
 
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_PERIPHERAL_INPUT_COALESCING)
+    input_coalescing_init();
+#endif
+
     return 0;
 }
 
@@ -350,11 +720,18 @@ int zmk_split_transport_peripheral_bt_report_event(
     switch (ev->type) {
     case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT:
         if (ev->data.key_position_event.pressed) {
-            zmk_split_bt_position_pressed(ev->data.key_position_event.position);
+            zmk_split_bt_position_pressed(ev->data.key_position_event.position,
+                                          ev->data.key_position_event.timestamp);
         } else {
-            zmk_split_bt_position_released(ev->data.key_position_event.position);
+            zmk_split_bt_position_released(ev->data.key_position_event.position,
+                                           ev->data.key_position_event.timestamp);
         }
         break;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_CLOCK_SYNC_EVENT:
+        return zmk_split_bt_clock_sync(ev->data.clock_sync_event.central_time,
+                                       ev->data.clock_sync_event.peripheral_time);
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
 #if ZMK_KEYMAP_HAS_SENSORS
     case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_SENSOR_EVENT:
         zmk_split_bt_sensor_triggered(ev->data.sensor_event.sensor_index,
@@ -29,6 +29,166 @@ static uint8_t peripheral_battery_levels[ZMK_SPLIT_CENTRAL_PERIPHERAL_COUNT] = {
 
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
 
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+
+struct clock_sync_sample {
+    uint32_t rtt;
+    int32_t offset;
+};
+
+struct clock_sync_state {
+    struct clock_sync_sample samples[CONFIG_ZMK_SPLIT_CLOCK_SYNC_SAMPLES];
+    uint8_t sample_count;
+    uint8_t next_sample;
+    struct zmk_split_central_transit_latency_stats stats;
+};
+
+static struct clock_sync_state clock_sync_states[ZMK_SPLIT_CENTRAL_PERIPHERAL_COUNT];
+
+static void clock_sync_reset(struct clock_sync_state *state) {
+    state->sample_count = 0;
+    state->next_sample = 0;
+    state->stats.synced = false;
+}
+
+static void clock_sync_add_sample(uint8_t source, uint32_t central_time, uint32_t peripheral_time) {
+    if (source >= ARRAY_SIZE(clock_sync_states)) {
+        return;
+    }
+
+    struct clock_sync_state *state = &clock_sync_states[source];
+    uint32_t rtt = k_uptime_get_32() - central_time;
+
+    if (rtt > 2 * CONFIG_ZMK_SPLIT_CLOCK_SYNC_MAX_TRANSIT) {
+        LOG_DBG("Discarding clock sync sample from %d with RTT %d", source, rtt);
+        return;
+    }
+
+    int32_t offset = (int32_t)(peripheral_time - (central_time + rtt / 2));
+
+    // A jump larger than the sample's own uncertainty means the peripheral clock was reset,
+    // e.g. by a reboot, so the older samples no longer apply.
+    if (state->stats.synced &&
+        abs(offset - state->stats.clock_offset) > rtt + state->stats.clock_sync_rtt + 1) {
+        LOG_DBG("Clock offset for %d jumped from %d to %d, resetting", source,
+                state->stats.clock_offset, offset);
+        clock_sync_reset(state);
+    }
+
+    state->samples[state->next_sample] = (struct clock_sync_sample){.rtt = rtt, .offset = offset};
+    state->next_sample = (state->next_sample + 1) % ARRAY_SIZE(state->samples);
+    state->sample_count = MIN(state->sample_count + 1, ARRAY_SIZE(state->samples));
+
+    // The sample with the shortest round trip has the smallest asymmetry error
+    const struct clock_sync_sample *best = &state->samples[0];
+    for (int i = 1; i < state->sample_count; i++) {
+        if (state->samples[i].rtt < best->rtt) {
+            best = &state->samples[i];
+        }
+    }
+
+    state->stats.clock_offset = best->offset;
+    state->stats.clock_sync_rtt = best->rtt;
+    state->stats.synced = true;
+}
+
+static void clock_sync_record_latency(struct clock_sync_state *state, uint32_t latency) {
+    uint8_t bucket = latency == 0 ? 0 : 32 - __builtin_clz(latency);
+
+    state->stats.buckets[MIN(bucket, ARRAY_SIZE(state->stats.buckets) - 1)]++;
+    state->stats.count++;
+    state->stats.total += latency;
+    state->stats.max = MAX(state->stats.max, latency);
+}
+
+static int64_t clock_sync_event_timestamp(uint8_t source, uint32_t peripheral_time) {
+    int64_t now = k_uptime_get();
+
+    if (source >= ARRAY_SIZE(clock_sync_states) || peripheral_time == 0) {
+        return now;
+    }
+
+    struct clock_sync_state *state = &clock_sync_states[source];
+    if (!state->stats.synced) {
+        return now;
+    }
+
+    int32_t latency = (int32_t)((uint32_t)now - (peripheral_time - state->stats.clock_offset));
+
+    // Small negative values are estimation error, not events from the future
+    latency = MAX(latency, 0);
+    if (latency > CONFIG_ZMK_SPLIT_CLOCK_SYNC_MAX_TRANSIT) {
+        LOG_DBG("Ignoring implausible transit latency %d from %d", latency, source);
+        return now;
+    }
+
+    clock_sync_record_latency(state, latency);
+
+    return now - latency;
+}
+
+int zmk_split_central_get_transit_latency_stats(
+    uint8_t source, struct zmk_split_central_transit_latency_stats *stats) {
+    if (source >= ARRAY_SIZE(clock_sync_states)) {
+        return -EINVAL;
+    }
+
+    *stats = clock_sync_states[source].stats;
+    return 0;
+}
+
+void zmk_split_central_reset_transit_latency_stats(uint8_t source) {
+    if (source >= ARRAY_SIZE(clock_sync_states)) {
+        return;
+    }
+
+    struct zmk_split_central_transit_latency_stats *stats = &clock_sync_states[source].stats;
+    stats->count = 0;
+    stats->max = 0;
+    stats->total = 0;
+    memset(stats->buckets, 0, sizeof(stats->buckets));
+}
+
+static void clock_sync_work_cb(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(clock_sync_work, clock_sync_work_cb);
+
+static void clock_sync_work_cb(struct k_work *work) {
+    bool warming_up = false;
+
+    if (active_transport && active_transport->api->get_available_source_ids &&
+        active_transport->api->send_command) {
+        uint8_t source_ids[ZMK_SPLIT_CENTRAL_PERIPHERAL_COUNT];
+        int count = active_transport->api->get_available_source_ids(source_ids);
+
+        for (int i = 0; i < count; i++) {
+            struct zmk_split_transport_central_command command = {
+                .type = ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SYNC_CLOCK,
+                .data = {.sync_clock = {.central_time = k_uptime_get_32()}},
+            };
+
+            int err = active_transport->api->send_command(source_ids[i], command);
+            if (err < 0) {
+                LOG_DBG("Failed to send clock sync to %d (%d)", source_ids[i], err);
+            }
+
+            if (source_ids[i] < ARRAY_SIZE(clock_sync_states) &&
+                clock_sync_states[source_ids[i]].sample_count <
+                    ARRAY_SIZE(clock_sync_states[source_ids[i]].samples)) {
+                warming_up = true;
+            }
+        }
+    }
+
+    // Sample quickly until the filter window is filled, then settle on the slower interval
+    k_work_schedule(&clock_sync_work,
+                    K_MSEC(warming_up ? CONFIG_ZMK_SPLIT_CLOCK_SYNC_INTERVAL /
+                                            CONFIG_ZMK_SPLIT_CLOCK_SYNC_SAMPLES
+                                      : CONFIG_ZMK_SPLIT_CLOCK_SYNC_INTERVAL));
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+
 int zmk_split_transport_central_peripheral_event_handler(
     const struct zmk_split_transport_central *transport, uint8_t source,
     struct zmk_split_transport_peripheral_event ev) {
@@ -39,13 +199,24 @@ int zmk_split_transport_central_peripheral_event_handler(
     }
     switch (ev.type) {
     case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_KEY_POSITION_EVENT: {
-        struct zmk_position_state_changed state_ev = {.source = source,
-                                                      .position =
-                                                          ev.data.key_position_event.position,
-                                                      .state = ev.data.key_position_event.pressed,
-                                                      .timestamp = k_uptime_get()};
+        struct zmk_position_state_changed state_ev = {
+            .source = source,
+            .position = ev.data.key_position_event.position,
+            .state = ev.data.key_position_event.pressed,
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+            .timestamp = clock_sync_event_timestamp(source, ev.data.key_position_event.timestamp),
+#else
+            .timestamp = k_uptime_get(),
+#endif
+        };
         return raise_zmk_position_state_changed(state_ev);
     }
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_CLOCK_SYNC_EVENT:
+        clock_sync_add_sample(source, ev.data.clock_sync_event.central_time,
+                              ev.data.clock_sync_event.peripheral_time);
+        return 0;
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
 #if IS_ENABLED(CONFIG_ZMK_INPUT_SPLIT)
     case ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_INPUT_EVENT: {
         return zmk_input_split_report_peripheral_event(
@@ -201,6 +372,17 @@ static int transport_status_changed_cb(const struct zmk_split_transport_central
     if (central == active_transport) {
         LOG_DBG("Central at %p changed status: enabled %d, available %d, connections %d", central,
                 status.enabled, status.available, status.connections);
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+        if (status.connections != ZMK_SPLIT_TRANSPORT_CONNECTIONS_STATUS_ALL_CONNECTED) {
+            for (int i = 0; i < ARRAY_SIZE(clock_sync_states); i++) {
+                clock_sync_reset(&clock_sync_states[i]);
+            }
+        }
+
+        if (status.connections != ZMK_SPLIT_TRANSPORT_CONNECTIONS_STATUS_DISCONNECTED) {
+            k_work_reschedule(&clock_sync_work, K_NO_WAIT);
+        }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
         if (status.connections == ZMK_SPLIT_TRANSPORT_CONNECTIONS_STATUS_DISCONNECTED) {
             return select_first_available_transport();
         }
@@ -221,6 +403,10 @@ static int central_init(void) {
         t->api->set_status_callback(transport_status_changed_cb);
     }
 
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    k_work_schedule(&clock_sync_work, K_MSEC(CONFIG_ZMK_SPLIT_CLOCK_SYNC_INTERVAL));
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+
     return select_first_available_transport();
 }
 
@@ -50,7 +50,20 @@ int zmk_split_transport_peripheral_command_handler(
         if (err) {
             LOG_ERR("Failed to invoke behavior %s: %d", binding.behavior_dev, err);
         }
+        break;
     }
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
+    case ZMK_SPLIT_TRANSPORT_CENTRAL_CMD_TYPE_SYNC_CLOCK: {
+        struct zmk_split_transport_peripheral_event ev = {
+            .type = ZMK_SPLIT_TRANSPORT_PERIPHERAL_EVENT_TYPE_CLOCK_SYNC_EVENT,
+            .data = {.clock_sync_event = {
+                         .central_time = cmd.data.sync_clock.central_time,
+                         .peripheral_time = k_uptime_get_32(),
+                     }}};
+
+        return zmk_split_peripheral_report_event(&ev);
+    }
+#endif // IS_ENABLED(CONFIG_ZMK_SPLIT_CLOCK_SYNC)
     default:
         LOG_WRN("Unhandled command type %d", cmd.type);
         return -ENOTSUP;
@@ -139,6 +152,7 @@ int split_peripheral_listener(const zmk_event_t *eh) {
             .data = {.key_position_event = {
                          .position = pos_ev->position,
                          .pressed = pos_ev->state,
+                         .timestamp = (uint32_t)pos_ev->timestamp,
                      }}};
 
         zmk_split_peripheral_report_event(&ev);
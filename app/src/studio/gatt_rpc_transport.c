@@ -9,14 +9,17 @@
 #include <sys/types.h>
 #include <zephyr/sys/atomic.h>
 #include <zephyr/kernel.h>
+#include <zephyr/bluetooth/att.h>
 #include <zephyr/bluetooth/gatt.h>
 #include <zephyr/sys/ring_buffer.h>
 
 #include <zmk/ble.h>
+#include <zmk/ble/conn_params.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/ble_active_profile_changed.h>
 #include <zmk/studio/rpc.h>
 
+#include "msg_framing.h"
 #include "uuid.h"
 
 #include <zephyr/logging/log.h>
@@ -27,14 +30,65 @@ static bool handling_rx = false;
 
 static atomic_t notify_size;
 
+// The CCC value the client subscribed with. Clients that enable notifications get responses
+// streamed without waiting for a confirmation of each chunk, others keep using indications.
+static atomic_t ccc_value;
+
+static void refresh_notify_size(void);
+
+static void rpc_mtu_exchanged(struct bt_conn *conn, uint8_t err,
+                              struct bt_gatt_exchange_params *params) {
+    if (err) {
+        LOG_WRN("Failed to exchange the ATT MTU (%d)", err);
+    }
+
+    refresh_notify_size();
+}
+
+static struct bt_gatt_exchange_params mtu_exchange_params = {
+    .func = rpc_mtu_exchanged,
+};
+
+static void request_max_throughput(struct bt_conn *conn) {
+    // Either of these may already have been done by the host, in which case they fail harmlessly
+    int ret = bt_gatt_exchange_mtu(conn, &mtu_exchange_params);
+    if (ret < 0 && ret != -EALREADY) {
+        LOG_DBG("Failed to request an ATT MTU exchange (%d)", ret);
+    }
+
+    ret = bt_conn_le_data_len_update(conn, BT_LE_DATA_LEN_PARAM_MAX);
+    if (ret < 0) {
+        LOG_DBG("Failed to request a data length update (%d)", ret);
+    }
+}
+
 static void rpc_ccc_cfg_changed(const struct bt_gatt_attr *attr, uint16_t value) {
     ARG_UNUSED(attr);
 
-    bool notif_enabled = (value == BT_GATT_CCC_INDICATE);
+    bool notif_enabled = (value & (BT_GATT_CCC_INDICATE | BT_GATT_CCC_NOTIFY)) != 0;
+
+    atomic_set(&ccc_value, value);
 
     LOG_INF("RPC Notifications %s", notif_enabled ? "enabled" : "disabled");
 
-#if CONFIG_ZMK_STUDIO_TRANSPORT_BLE_PREF_LATENCY < CONFIG_BT_PERIPHERAL_PREF_LATENCY
+    if (notif_enabled) {
+        struct bt_conn *conn = zmk_ble_active_profile_conn();
+        if (conn) {
+            request_max_throughput(conn);
+            bt_conn_unref(conn);
+        }
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_BLE_CONN_PARAMS)
+    // Have the connection parameter scheduler keep the link responsive, any update requested here
+    // would be undone by its next profile change
+    if (notif_enabled) {
+        zmk_ble_conn_params_hold_active(MIN(CONFIG_ZMK_STUDIO_TRANSPORT_BLE_PREF_LATENCY,
+                                            CONFIG_BT_PERIPHERAL_PREF_LATENCY));
+    } else {
+        zmk_ble_conn_params_release_active();
+    }
+#elif CONFIG_ZMK_STUDIO_TRANSPORT_BLE_PREF_LATENCY < CONFIG_BT_PERIPHERAL_PREF_LATENCY
     struct bt_conn *conn = zmk_ble_active_profile_conn();
     if (conn) {
         uint8_t latency = notif_enabled ? CONFIG_ZMK_STUDIO_TRANSPORT_BLE_PREF_LATENCY
@@ -78,6 +132,13 @@ static ssize_t write_rpc_req(struct bt_conn *conn, const struct bt_gatt_attr *at
         }
 
         ring_buf_put_finish(rpc_buf, claim_len);
+
+        if (claim_len == 0) {
+            // Writes without response have no flow control of their own, so let the RPC thread
+            // drain the buffer instead of spinning until it does.
+            zmk_rpc_rx_notify();
+            k_sleep(K_MSEC(1));
+        }
     }
 
     zmk_rpc_rx_notify();
@@ -88,19 +149,17 @@ static ssize_t write_rpc_req(struct bt_conn *conn, const struct bt_gatt_attr *at
 BT_GATT_SERVICE_DEFINE(
     rpc_interface, BT_GATT_PRIMARY_SERVICE(BT_UUID_DECLARE_128(ZMK_STUDIO_BT_SERVICE_UUID)),
     BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_STUDIO_BT_RPC_CHRC_UUID),
-                           BT_GATT_CHRC_WRITE | BT_GATT_CHRC_READ | BT_GATT_CHRC_INDICATE,
+                           BT_GATT_CHRC_WRITE | BT_GATT_CHRC_WRITE_WITHOUT_RESP |
+                               BT_GATT_CHRC_READ | BT_GATT_CHRC_INDICATE | BT_GATT_CHRC_NOTIFY,
                            BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT, read_rpc_resp,
                            write_rpc_req, NULL),
     BT_GATT_CCC(rpc_ccc_cfg_changed, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT));
 
 static uint16_t get_notify_size_for_conn(struct bt_conn *conn) {
-    uint16_t notify_size = 23; // Default MTU size unless negotiated higher
-    struct bt_conn_info conn_info;
-    if (conn && bt_conn_get_info(conn, &conn_info) >= 0) {
-        notify_size = conn_info.le.data_len->tx_max_len;
-    }
+    // Default MTU size unless negotiated higher, less the ATT header of the notification
+    uint16_t mtu = conn ? bt_gatt_get_mtu(conn) : BT_ATT_DEFAULT_LE_MTU;
 
-    return notify_size;
+    return MAX(mtu, BT_ATT_DEFAULT_LE_MTU) - 3;
 }
 
 static void refresh_notify_size(void) {
@@ -125,9 +184,110 @@ static int gatt_stop_rx(void) {
     return 0;
 }
 
-static struct bt_gatt_indicate_params rpc_indicate_params = {
-    .attr = &rpc_interface.attrs[1],
-};
+#define TX_PIPELINE_DEPTH CONFIG_ZMK_STUDIO_TRANSPORT_BLE_TX_PIPELINE_DEPTH
+
+#define TX_ATTEMPTS 5
+#define TX_SLOT_TIMEOUT_MS 200
+
+// Bounds the notifications or indications queued in the stack at once, so a long response is
+// pipelined over several connection events without exhausting the stack's TX buffers.
+static K_SEM_DEFINE(tx_slots, TX_PIPELINE_DEPTH, TX_PIPELINE_DEPTH);
+
+static struct bt_gatt_indicate_params rpc_indicate_params[TX_PIPELINE_DEPTH];
+static ATOMIC_DEFINE(rpc_indicate_params_busy, TX_PIPELINE_DEPTH);
+
+static void rpc_notify_sent(struct bt_conn *conn, void *user_data) { k_sem_give(&tx_slots); }
+
+static void rpc_indicate_destroy(struct bt_gatt_indicate_params *params) {
+    atomic_clear_bit(rpc_indicate_params_busy, params - rpc_indicate_params);
+    k_sem_give(&tx_slots);
+}
+
+static int send_rpc_chunk(struct bt_conn *conn, const uint8_t *data, uint16_t len) {
+    if (atomic_get(&ccc_value) == BT_GATT_CCC_NOTIFY) {
+        struct bt_gatt_notify_params notify_params = {
+            .attr = &rpc_interface.attrs[1],
+            .data = data,
+            .len = len,
+            .func = rpc_notify_sent,
+        };
+
+        return bt_gatt_notify_cb(conn, &notify_params);
+    }
+
+    for (int i = 0; i < TX_PIPELINE_DEPTH; i++) {
+        if (atomic_test_and_set_bit(rpc_indicate_params_busy, i)) {
+            continue;
+        }
+
+        struct bt_gatt_indicate_params *params = &rpc_indicate_params[i];
+        *params = (struct bt_gatt_indicate_params){
+            .attr = &rpc_interface.attrs[1],
+            .data = data,
+            .len = len,
+            .destroy = rpc_indicate_destroy,
+        };
+
+        int err = bt_gatt_indicate(conn, params);
+        if (err < 0) {
+            atomic_clear_bit(rpc_indicate_params_busy, i);
+        }
+
+        return err;
+    }
+
+    return -EBUSY;
+}
+
+// Set once a chunk of a response could not be sent, the rest of that response is then dropped
+// up to its end of frame so the client never gets a frame with a hole in it.
+static bool dropping_response;
+static bool dropping_escaped;
+
+static void track_dropped_byte(uint8_t b) {
+    if (dropping_escaped) {
+        dropping_escaped = false;
+    } else if (b == FRAMING_ESC) {
+        dropping_escaped = true;
+    } else if (b == FRAMING_EOF) {
+        dropping_response = false;
+    }
+}
+
+static void drop_response_bytes(struct ring_buf *tx_buf) {
+    while (dropping_response && ring_buf_size_get(tx_buf) > 0) {
+        uint8_t b;
+        ring_buf_get(tx_buf, &b, 1);
+        track_dropped_byte(b);
+    }
+}
+
+static int send_rpc_chunk_with_retries(struct bt_conn *conn, const uint8_t *data, uint16_t len) {
+    int err = -EAGAIN;
+
+    for (int attempt = 0; attempt < TX_ATTEMPTS; attempt++) {
+        // The stack copies the data when queueing it, so only the slot is held until the chunk is
+        // sent or confirmed. Those callbacks run on the system work queue or the BT TX thread,
+        // never on the TX queue blocked here.
+        if (k_sem_take(&tx_slots, K_MSEC(TX_SLOT_TIMEOUT_MS)) < 0) {
+            LOG_WRN("Timed out waiting for earlier responses to be sent");
+            err = -ETIMEDOUT;
+            continue;
+        }
+
+        err = send_rpc_chunk(conn, data, len);
+        if (err >= 0) {
+            return err;
+        }
+
+        k_sem_give(&tx_slots);
+
+        LOG_WRN("Failed to notify the response %d", err);
+        k_sleep(K_MSEC(TX_SLOT_TIMEOUT_MS));
+    }
+
+    return err;
+}
 
 static void notif_rpc_tx_cb(struct k_work *work) {
     struct bt_conn *conn = zmk_ble_active_profile_conn();
@@ -142,6 +302,8 @@ static void notif_rpc_tx_cb(struct k_work *work) {
     uint16_t notify_size = get_notify_size_for_conn(conn);
     uint8_t notify_bytes[notify_size];
 
+    drop_response_bytes(tx_buf);
+
     while (ring_buf_size_get(tx_buf) > 0) {
         uint16_t added = 0;
         while (added < notify_size && ring_buf_size_get(tx_buf) > 0) {
@@ -154,19 +316,20 @@ static void notif_rpc_tx_cb(struct k_work *work) {
             ring_buf_get_finish(tx_buf, len);
         }
 
-        rpc_indicate_params.data = notify_bytes;
-        rpc_indicate_params.len = added;
+        int err = send_rpc_chunk_with_retries(conn, notify_bytes, added);
+        if (err < 0) {
+            LOG_ERR("Failed to send the response (%d), dropping the rest of it", err);
 
-        int notify_attempts = 5;
-        do {
-            int err = bt_gatt_indicate(conn, &rpc_indicate_params);
-            if (err >= 0) {
-                break;
+            // Work out where the failed chunk left off, to know whether it already held the end
+            // of the frame
+            dropping_response = true;
+            dropping_escaped = false;
+            for (int i = 0; i < added && dropping_response; i++) {
+                track_dropped_byte(notify_bytes[i]);
             }
 
-            LOG_WRN("Failed to notify the response %d", err);
-            k_sleep(K_MSEC(200));
-        } while (notify_attempts-- > 0);
+            drop_response_bytes(tx_buf);
+        }
     }
 
     bt_conn_unref(conn);
@@ -174,6 +337,12 @@ static void notif_rpc_tx_cb(struct k_work *work) {
 
 static K_WORK_DEFINE(notify_tx_work, notif_rpc_tx_cb);
 
+// Sending blocks until the stack frees a TX slot, which happens from the system work queue, so the
+// chunks are sent from a queue of their own. It runs ahead of the RPC thread filling the buffer.
+K_THREAD_STACK_DEFINE(rpc_tx_q_stack, CONFIG_ZMK_STUDIO_TRANSPORT_BLE_TX_STACK_SIZE);
+
+static struct k_work_q rpc_tx_work_q;
+
 struct gatt_write_state {
     size_t pending_notify;
 };
@@ -186,7 +355,7 @@ static void gatt_tx_notify(struct ring_buf *tx_buf, size_t added, bool msg_done,
     atomic_t ns = atomic_get(&notify_size);
 
     if (msg_done || state->pending_notify > ns) {
-        k_work_submit(&notify_tx_work);
+        k_work_submit_to_queue(&rpc_tx_work_q, &notify_tx_work);
         state->pending_notify = 0;
     }
 }
@@ -202,6 +371,26 @@ static void *gatt_tx_user_data(void) {
 ZMK_RPC_TRANSPORT(gatt, ZMK_TRANSPORT_BLE, gatt_start_rx, gatt_stop_rx, gatt_tx_user_data,
                   gatt_tx_notify);
 
+static void rpc_att_mtu_updated(struct bt_conn *conn, uint16_t tx, uint16_t rx) {
+    refresh_notify_size();
+}
+
+static struct bt_gatt_cb rpc_gatt_callbacks = {
+    .att_mtu_updated = rpc_att_mtu_updated,
+};
+
+static int gatt_rpc_init(void) {
+    static const struct k_work_queue_config queue_config = {.name = "Studio BLE TX Work Queue"};
+    k_work_queue_start(&rpc_tx_work_q, rpc_tx_q_stack, K_THREAD_STACK_SIZEOF(rpc_tx_q_stack),
+                       K_LOWEST_APPLICATION_THREAD_PRIO - 1, &queue_config);
+
+    bt_gatt_cb_register(&rpc_gatt_callbacks);
+
+    return 0;
+}
+
+SYS_INIT(gatt_rpc_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
 static int gatt_rpc_listener(const zmk_event_t *eh) {
     refresh_notify_size();
 
@@ -23,26 +23,66 @@ ZMK_RPC_SUBSYSTEM(keymap)
 #define KEYMAP_RESPONSE(type, ...) ZMK_RPC_RESPONSE(keymap, type, __VA_ARGS__)
 #define KEYMAP_NOTIFICATION(type, ...) ZMK_RPC_NOTIFICATION(keymap, type, __VA_ARGS__)
 
-static bool encode_layer_bindings(pb_ostream_t *stream, const pb_field_t *field, void *const *arg) {
-    const zmk_keymap_layer_id_t layer_id = *(uint8_t *)*arg;
+struct encode_bindings_state {
+    pb_ostream_t *stream;
+    const pb_field_t *field;
+    uint16_t encoded;
+    const char *last_name;
+    zmk_behavior_local_id_t last_local_id;
+};
+
+static bool encode_binding(struct encode_bindings_state *state,
+                           const zmk_keymap_BehaviorBinding *bb) {
+    if (!pb_encode_tag_for_field(state->stream, state->field)) {
+        return false;
+    }
 
-    for (int b = 0; b < ZMK_KEYMAP_LEN; b++) {
-        const struct zmk_behavior_binding *binding =
-            zmk_keymap_get_layer_binding_at_idx(layer_id, b);
+    if (!pb_encode_submessage(state->stream, &zmk_keymap_BehaviorBinding_msg, bb)) {
+        return false;
+    }
 
-        zmk_keymap_BehaviorBinding bb = zmk_keymap_BehaviorBinding_init_zero;
+    state->encoded++;
+    return true;
+}
 
-        if (binding && binding->behavior_dev) {
-            bb.behavior_id = zmk_behavior_get_local_id(binding->behavior_dev);
-            bb.param1 = binding->param1;
-            bb.param2 = binding->param2;
+static int encode_layer_binding(uint16_t binding_idx, const struct zmk_behavior_binding *binding,
+                                void *user_data) {
+    struct encode_bindings_state *state = user_data;
+    zmk_keymap_BehaviorBinding bb = zmk_keymap_BehaviorBinding_init_zero;
+
+    if (binding && binding->behavior_dev) {
+        // Neighbouring keys very often share a behavior, e.g. runs of &kp or &trans, and bindings
+        // of the same behavior share the name pointer, so only look up the local ID when it
+        // changes.
+        if (binding->behavior_dev != state->last_name) {
+            state->last_name = binding->behavior_dev;
+            state->last_local_id = zmk_behavior_get_local_id(binding->behavior_dev);
         }
 
-        if (!pb_encode_tag_for_field(stream, field)) {
-            return false;
-        }
+        bb.behavior_id = state->last_local_id;
+        bb.param1 = binding->param1;
+        bb.param2 = binding->param2;
+    }
+
+    return encode_binding(state, &bb) ? 0 : -EIO;
+}
+
+static bool encode_layer_bindings(pb_ostream_t *stream, const pb_field_t *field, void *const *arg) {
+    const zmk_keymap_layer_id_t layer_id = *(uint8_t *)*arg;
+    struct encode_bindings_state state = {.stream = stream, .field = field};
+
+    // Bindings are encoded straight from the keymap while walking it, nanopb calls this once to
+    // size the layer and once more to write it.
+    int ret = zmk_keymap_foreach_layer_binding(layer_id, encode_layer_binding, &state);
+    if (ret < 0) {
+        LOG_WRN("Failed to encode the bindings of layer %d (%d)", layer_id, ret);
+        return false;
+    }
 
-        if (!pb_encode_submessage(stream, &zmk_keymap_BehaviorBinding_msg, &bb)) {
+    // Positions past the selected physical layout are sent as empty bindings
+    const zmk_keymap_BehaviorBinding empty = zmk_keymap_BehaviorBinding_init_zero;
+    while (state.encoded < ZMK_KEYMAP_LEN) {
+        if (!encode_binding(&state, &empty)) {
             return false;
         }
     }
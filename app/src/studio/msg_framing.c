@@ -77,4 +77,35 @@ bool studio_framing_process_byte(enum studio_framing_state *rpc_framing_state, u
         LOG_ERR("Unsupported framing state: %d", *rpc_framing_state);
         return false;
     }
-}
\ No newline at end of file
+}
+
+static inline bool is_framing_byte(uint8_t c) {
+    return (uint8_t)(c - FRAMING_SOF) <= (FRAMING_EOF - FRAMING_SOF);
+}
+
+size_t studio_framing_process_bytes(enum studio_framing_state *rpc_framing_state, const uint8_t *in,
+                                    size_t in_len, uint8_t *out, size_t out_len,
+                                    size_t *out_written) {
+    size_t i = 0, o = 0;
+
+    while (i < in_len && o < out_len && *rpc_framing_state != FRAMING_STATE_EOF) {
+        if (*rpc_framing_state == FRAMING_STATE_AWAITING_DATA) {
+            size_t end = i + MIN(in_len - i, out_len - o);
+
+            while (i < end && !is_framing_byte(in[i])) {
+                out[o++] = in[i++];
+            }
+
+            if (i == end) {
+                break;
+            }
+        }
+
+        if (studio_framing_process_byte(rpc_framing_state, in[i++])) {
+            out[o++] = in[i - 1];
+        }
+    }
+
+    *out_written = o;
+    return i;
+}
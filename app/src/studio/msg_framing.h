@@ -29,3 +29,19 @@ enum studio_framing_state {
  * has been updated.
  */
 bool studio_framing_process_byte(enum studio_framing_state *frame_state, uint8_t data);
+
+/**
+ * @brief Process a run of incoming bytes, unescaping the frame data into @p out . Runs of plain
+ * data are copied in a tight loop, only framing bytes go through the framing state machine.
+ * @param frame_state The framing state, updated as framing bytes are processed.
+ * @param in The incoming bytes.
+ * @param in_len The number of incoming bytes.
+ * @param out Buffer for the unescaped frame data.
+ * @param out_len The room available in @p out .
+ * @param out_written Set to the number of bytes written to @p out .
+ * @return The number of incoming bytes consumed, which stops short of @p in_len once @p out is full
+ * or right after the end of a frame, leaving the data of any following frame unprocessed.
+ */
+size_t studio_framing_process_bytes(enum studio_framing_state *frame_state, const uint8_t *in,
+                                    size_t in_len, uint8_t *out, size_t out_len,
+                                    size_t *out_written);
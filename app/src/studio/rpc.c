@@ -83,23 +83,24 @@ struct ring_buf *zmk_rpc_get_rx_buf(void) { return &rpc_rx_buf; }
 void zmk_rpc_rx_notify(void) { k_sem_give(&rpc_rx_sem); }
 
 static bool rpc_read_cb(pb_istream_t *stream, uint8_t *buf, size_t count) {
-    uint32_t write_offset = 0;
+    size_t write_offset = 0;
 
     do {
         uint8_t *buffer;
-        uint32_t len = ring_buf_get_claim(&rpc_rx_buf, &buffer, count);
+        uint32_t len = ring_buf_get_claim(&rpc_rx_buf, &buffer, rpc_rx_buf.size);
 
-        if (len > 0) {
-            for (int i = 0; i < len; i++) {
-                if (studio_framing_process_byte(&rpc_framing_state, buffer[i])) {
-                    buf[write_offset++] = buffer[i];
-                }
-            }
-        } else {
+        if (len == 0) {
             k_sem_take(&rpc_rx_sem, K_FOREVER);
+            continue;
         }
 
-        ring_buf_get_finish(&rpc_rx_buf, len);
+        size_t written;
+        size_t consumed = studio_framing_process_bytes(&rpc_framing_state, buffer, len,
+                                                       buf + write_offset, count - write_offset,
+                                                       &written);
+
+        write_offset += written;
+        ring_buf_get_finish(&rpc_rx_buf, consumed);
     } while (write_offset < count && rpc_framing_state != FRAMING_STATE_EOF);
 
     if (rpc_framing_state == FRAMING_STATE_EOF) {
@@ -46,7 +46,7 @@ static void uart_rx_main(void) {
     for (;;) {
         uint8_t *buf;
         struct ring_buf *ring_buf = zmk_rpc_get_rx_buf();
-        uint32_t claim_len = ring_buf_put_claim(ring_buf, &buf, 1);
+        uint32_t claim_len = ring_buf_put_claim(ring_buf, &buf, ring_buf->size);
 
         if (claim_len < 1) {
             LOG_WRN("NO CLAIM ABLE TO BE HAD");
@@ -54,12 +54,18 @@ static void uart_rx_main(void) {
             continue;
         }
 
-        if (uart_poll_in(uart_dev, buf) < 0) {
-            ring_buf_put_finish(ring_buf, 0);
-            k_sleep(K_MSEC(1));
-        } else {
-            ring_buf_put_finish(ring_buf, 1);
+        // Drain everything the UART has pending into the claim, and hand it over in one go
+        uint32_t read = 0;
+        while (read < claim_len && uart_poll_in(uart_dev, &buf[read]) == 0) {
+            read++;
+        }
+
+        ring_buf_put_finish(ring_buf, read);
+
+        if (read > 0) {
             zmk_rpc_rx_notify();
+        } else {
+            k_sleep(K_MSEC(1));
         }
     }
 }
@@ -119,7 +125,9 @@ static void serial_cb(const struct device *dev, void *user_data) {
             }
         } while (last_read && last_read == len);
 
-        zmk_rpc_rx_notify();
+        if (!ring_buf_is_empty(buf)) {
+            zmk_rpc_rx_notify();
+        }
     }
 
     if (uart_irq_tx_ready(uart_dev)) {
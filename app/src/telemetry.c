@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2025 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/atomic.h>
+
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#endif
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/event_manager.h>
+#include <zmk/events/position_state_changed.h>
+#include <zmk/events/keycode_state_changed.h>
+#include <zmk/events/layer_state_changed.h>
+#include <zmk/events/sensor_event.h>
+#include <zmk/events/telemetry_updated.h>
+#include <zmk/telemetry.h>
+
+// The hot paths only ever do an atomic increment or compare, everything else happens in the
+// periodic work, which is what bounds the cost of telemetry to once per interval.
+static atomic_t kscan_events;
+static atomic_t hid_reports;
+static atomic_t event_counts[ZMK_TELEMETRY_EVENT_COUNT];
+static atomic_t queue_high_water[ZMK_TELEMETRY_QUEUE_COUNT];
+
+static int64_t period_start;
+
+void zmk_telemetry_record_queue_depth(enum zmk_telemetry_queue queue, uint32_t depth) {
+    atomic_val_t high_water = atomic_get(&queue_high_water[queue]);
+
+    while (depth > high_water) {
+        if (atomic_cas(&queue_high_water[queue], high_water, depth)) {
+            break;
+        }
+
+        high_water = atomic_get(&queue_high_water[queue]);
+    }
+}
+
+void zmk_telemetry_record_kscan_event(void) { atomic_inc(&kscan_events); }
+
+void zmk_telemetry_record_hid_report(void) { atomic_inc(&hid_reports); }
+
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+
+static void record_conn_interval(struct bt_conn *conn, void *data) {
+    struct zmk_telemetry_snapshot *snapshot = data;
+    struct bt_conn_info info;
+
+    if (bt_conn_get_info(conn, &info) < 0 || info.state != BT_CONN_STATE_CONNECTED) {
+        return;
+    }
+
+    switch (info.role) {
+    case BT_CONN_ROLE_PERIPHERAL:
+        snapshot->host_conn_interval = MAX(snapshot->host_conn_interval, info.le.interval);
+        break;
+    case BT_CONN_ROLE_CENTRAL:
+        snapshot->split_conn_interval = MAX(snapshot->split_conn_interval, info.le.interval);
+        break;
+    default:
+        break;
+    }
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_BLE)
+
+static void telemetry_work_cb(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(telemetry_work, telemetry_work_cb);
+
+static void telemetry_work_cb(struct k_work *work) {
+    int64_t now = k_uptime_get();
+    struct zmk_telemetry_snapshot snapshot = {
+        .period_ms = (uint32_t)(now - period_start),
+        .kscan_events = (uint32_t)atomic_clear(&kscan_events),
+        .hid_reports = (uint32_t)atomic_clear(&hid_reports),
+    };
+
+    for (int i = 0; i < ZMK_TELEMETRY_EVENT_COUNT; i++) {
+        snapshot.event_counts[i] = (uint32_t)atomic_clear(&event_counts[i]);
+    }
+
+    for (int i = 0; i < ZMK_TELEMETRY_QUEUE_COUNT; i++) {
+        snapshot.queue_high_water[i] = (uint16_t)atomic_clear(&queue_high_water[i]);
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+    bt_conn_foreach(BT_CONN_TYPE_LE, record_conn_interval, &snapshot);
+#endif
+
+    period_start = now;
+
+    raise_zmk_telemetry_updated((struct zmk_telemetry_updated){.snapshot = snapshot});
+
+    k_work_schedule(&telemetry_work, K_MSEC(CONFIG_ZMK_TELEMETRY_INTERVAL));
+}
+
+static int telemetry_listener(const zmk_event_t *eh) {
+    if (as_zmk_position_state_changed(eh)) {
+        atomic_inc(&event_counts[ZMK_TELEMETRY_EVENT_POSITION]);
+    } else if (as_zmk_keycode_state_changed(eh)) {
+        atomic_inc(&event_counts[ZMK_TELEMETRY_EVENT_KEYCODE]);
+    } else if (as_zmk_layer_state_changed(eh)) {
+        atomic_inc(&event_counts[ZMK_TELEMETRY_EVENT_LAYER]);
+    } else if (as_zmk_sensor_event(eh)) {
+        atomic_inc(&event_counts[ZMK_TELEMETRY_EVENT_SENSOR]);
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(telemetry, telemetry_listener);
+ZMK_SUBSCRIPTION(telemetry, zmk_position_state_changed);
+ZMK_SUBSCRIPTION(telemetry, zmk_keycode_state_changed);
+ZMK_SUBSCRIPTION(telemetry, zmk_layer_state_changed);
+ZMK_SUBSCRIPTION(telemetry, zmk_sensor_event);
+
+static int zmk_telemetry_init(void) {
+    period_start = k_uptime_get();
+    k_work_schedule(&telemetry_work, K_MSEC(CONFIG_ZMK_TELEMETRY_INTERVAL));
+
+    return 0;
+}
+
+SYS_INIT(zmk_telemetry_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);